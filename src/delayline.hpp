@@ -0,0 +1,252 @@
+// Copyright (C) 2015-2025  Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+#include <juce_core/juce_core.h>
+
+#include "kernels.hpp"
+
+/** How the samples of a delay line are held in memory. The narrow formats
+    halve the footprint and the cache traffic of the lines, for a little
+    noise: bfloat16 keeps float's range with 8 bits of mantissa, int16 keeps
+    16 bits of resolution below a fixed full scale. */
+enum class DelayFormat { float32 = 0, bfloat16, int16 };
+
+/** Returns the size of one stored sample. */
+constexpr size_t getBytesPerSample (const DelayFormat format) noexcept {
+    return format == DelayFormat::float32 ? sizeof (float)
+                                          : (format == DelayFormat::bfloat16 ? sizeof (kernels::BFloat16)
+                                                                              : sizeof (std::int16_t));
+}
+
+inline const char* getDelayFormatName (const DelayFormat format) noexcept {
+    return format == DelayFormat::float32 ? "float32" : (format == DelayFormat::bfloat16 ? "bfloat16" : "int16");
+}
+
+/** Calls function with a null pointer of the type the format is stored as, so
+    it can pick up the type and instantiate for it. */
+template <typename Function>
+decltype (auto) visitStorage (const DelayFormat format, Function&& function) {
+    switch (format) {
+        case DelayFormat::bfloat16:
+            return function ((kernels::BFloat16*) nullptr);
+        case DelayFormat::int16:
+            return function ((std::int16_t*) nullptr);
+        case DelayFormat::float32:
+        default:
+            break;
+    }
+    return function ((float*) nullptr);
+}
+
+/** A fixed length delay line used by the comb and allpass filters.
+
+    Storage is padded to a power of two so positions wrap with a mask instead
+    of a modulo. The tap is read delay samples behind the write position.
+    The line doesn't own its memory, see DelayArena, and doesn't know what
+    type its samples are stored as beyond the format: callers pass the type
+    along to the accessors, usually from visitStorage().
+
+    The line hands out contiguous spans for block kernels: getNumContiguous() returns how many samples can be read from
+    getReadPointer() and written to getWritePointer() before either position
+    wraps, and advance() moves both positions on afterwards.
+*/
+class DelayLine {
+public:
+    DelayLine() = default;
+
+    /** Returns the storage size needed for a delay of numSamples. */
+    static constexpr int getCapacityFor (const int numSamples) noexcept {
+        int capacity = 1;
+        while (capacity < numSamples)
+            capacity <<= 1;
+        return capacity;
+    }
+
+    /** Points the line at its storage and sets the delay length, then clears it. */
+    void setStorage (void* const data, const DelayFormat formatToUse, const int numSamples) noexcept {
+        jassert (data != nullptr && numSamples > 0);
+        buffer = static_cast<char*> (data);
+        format = formatToUse;
+        capacity = getCapacityFor (numSamples);
+        mask = capacity - 1;
+        delay = numSamples;
+        clear();
+    }
+
+    /** Detaches the line from its storage, for a line that's out of use. */
+    void resetStorage() noexcept {
+        buffer = nullptr;
+        capacity = mask = delay = 0;
+        readPos = writePos = 0;
+    }
+
+    void clear() noexcept {
+        writePos = 0;
+        readPos = (writePos - delay) & mask;
+        if (buffer != nullptr)
+            memset (buffer, 0, getBytesPerSample (format) * (size_t) capacity);
+    }
+
+    int getDelay() const noexcept { return delay; }
+    int getCapacity() const noexcept { return capacity; }
+    DelayFormat getFormat() const noexcept { return format; }
+
+    /** Returns the largest magnitude held anywhere in the storage, including
+        samples already read, so nothing the line could still play is missed. */
+    float getPeak() const noexcept {
+        return visitStorage (format, [this] (auto* stored) {
+            using Stored = std::remove_pointer_t<decltype (stored)>;
+            const Stored* const samples = reinterpret_cast<const Stored*> (buffer);
+            float peak = 0.0f;
+            for (int i = 0; i < capacity; ++i)
+                peak = juce::jmax (peak, std::abs (kernels::Storage<Stored>::load (samples[i])));
+            return peak;
+        });
+    }
+
+    int getNumContiguous (const int numSamples) const noexcept {
+        return juce::jmin (numSamples, capacity - readPos, capacity - writePos);
+    }
+
+    template <typename Stored>
+    const Stored* getReadPointer() const noexcept {
+        jassert (getBytesPerSample (format) == sizeof (Stored));
+        return reinterpret_cast<const Stored*> (buffer) + readPos;
+    }
+
+    template <typename Stored>
+    Stored* getWritePointer() noexcept {
+        jassert (getBytesPerSample (format) == sizeof (Stored));
+        return reinterpret_cast<Stored*> (buffer) + writePos;
+    }
+
+    void advance (const int numSamples) noexcept {
+        readPos = (readPos + numSamples) & mask;
+        writePos = (writePos + numSamples) & mask;
+    }
+
+    /** A line can also be looped: the read position goes round the last delay
+        samples written while the write position holds still, which plays
+        the line back exactly as recirculating it with unity feedback would,
+        without writing anything. getLoopOffset() is how far into the loop the
+        read position is, 0 whenever the line isn't looping. */
+    int getLoopOffset() const noexcept { return (readPos - writePos + delay) & mask; }
+
+    int getNumContiguousInLoop (const int numSamples) const noexcept {
+        return juce::jmin (numSamples, delay - getLoopOffset(), capacity - readPos);
+    }
+
+    void advanceLoop (const int numSamples) noexcept {
+        const int offset = getLoopOffset() + numSamples;
+        jassert (offset <= delay);
+        readPos = (writePos - delay + (offset == delay ? 0 : offset)) & mask;
+    }
+
+    /** Carries on from a loop as if it had been recirculated all along. The
+        samples already played round again are copied up to the write
+        position, which is moved past them. */
+    void endLoop() noexcept {
+        const int offset = getLoopOffset();
+        const size_t bytesPerSample = getBytesPerSample (format);
+        const int loopStart = writePos - delay;
+
+        for (int i = 0; i < offset; ++i)
+            memcpy (buffer + (size_t) ((writePos + i) & mask) * bytesPerSample,
+                    buffer + (size_t) ((loopStart + i) & mask) * bytesPerSample, bytesPerSample);
+
+        writePos = (writePos + offset) & mask;
+    }
+
+private:
+    char* buffer { nullptr };
+    DelayFormat format { DelayFormat::float32 };
+    int capacity { 0 };
+    int mask { 0 };
+    int delay { 0 };
+    int readPos { 0 };
+    int writePos { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE (DelayLine)
+};
+
+//==============================================================================
+/** One cache-aligned allocation holding every delay line of a reverb.
+
+    Lines are laid out back to back in the order given, which should follow
+    the order the kernels touch them. A spare cache line follows each line, so
+    the power-of-two sized lines don't all start at the same offset within a
+    page. Without it lines of equal size land in the same cache sets, and the
+    left/right lines, whose positions move in lockstep, alias at 4K.
+*/
+class DelayArena {
+public:
+    enum { alignment = 64, maxLines = 128 };
+
+    DelayArena() = default;
+
+    /** Returns the number of bytes prepare() lays out for the given delay lengths. */
+    static constexpr size_t getSizeFor (const DelayFormat* formats, const int* delays, const int numLinesToUse) noexcept {
+        size_t total = 0;
+        for (int i = 0; i < numLinesToUse; ++i)
+            total += (size_t) DelayLine::getCapacityFor (delays[i]) * getBytesPerSample (formats[i]) + alignment;
+        return total;
+    }
+
+    /** Lays out lines of the given delay lengths and formats and allocates
+        them. Memory is only reallocated when the total size changes. */
+    void prepare (const DelayFormat* formatsToUse, const int* delays, const int numLinesToUse) {
+        jassert (numLinesToUse <= maxLines);
+        size_t total = 0;
+
+        for (int i = 0; i < numLinesToUse; ++i) {
+            offsets[i] = total;
+            formats[i] = formatsToUse[i];
+            total += (size_t) DelayLine::getCapacityFor (delays[i]) * getBytesPerSample (formats[i]) + alignment;
+        }
+
+        numLines = numLinesToUse;
+
+        if (total != numBytes) {
+            storage.allocate (total + alignment, true);
+            numBytes = total;
+        }
+    }
+
+    DelayFormat getFormat (const int index) const noexcept {
+        jassert (index < numLines);
+        return formats[index];
+    }
+
+    void* getLine (const int index) const noexcept {
+        jassert (index < numLines);
+        return juce::snapPointerToAlignment (storage.get(), alignment) + offsets[index];
+    }
+
+    /** Returns the memory taken by the delay lines, padding included. */
+    size_t getSizeInBytes() const noexcept { return numBytes; }
+
+    /** Exchanges lines and memory with another arena, without allocating. */
+    void swapWith (DelayArena& other) noexcept {
+        storage.swapWith (other.storage);
+        std::swap (formats, other.formats);
+        std::swap (numBytes, other.numBytes);
+        std::swap (offsets, other.offsets);
+        std::swap (numLines, other.numLines);
+    }
+
+private:
+    juce::HeapBlock<char> storage;
+    size_t numBytes { 0 };
+    size_t offsets[maxLines] {};
+    DelayFormat formats[maxLines] {};
+    int numLines { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE (DelayArena)
+};
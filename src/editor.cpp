@@ -37,6 +37,7 @@ void Editor::resized()
 void Editor::timerCallback()
 {
     view->setSphereValue (processor.getRMS());
+    view->setEngineLoad (processor.getDelayMemorySize(), processor.getProcessingLoad());
     view->updateParameterValueDisplays ();
     processor.processPendingUIUpdates(); // Process any pending switch updates
 }
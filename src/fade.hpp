@@ -0,0 +1,111 @@
+// Copyright (C) 2015-2025  Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#pragma once
+
+#include <cmath>
+
+#include <juce_core/juce_core.h>
+
+/** The shapes a filter crossfade can follow. Equal power keeps the summed
+    level of the comb bank steady while one filter fades in and another out. */
+enum class FadeCurve { linear = 0, equalPower, numCurves };
+
+/** Fade curves tabulated over 0..1, so rendering a fade costs a table lookup
+    per sample. Each curve has a rising and a falling table: the equal power
+    curve rises along sin and falls along cos, written as how far from the
+    start gain towards the target the fade has got. */
+struct FadeTables {
+    enum { size = 512 };
+
+    /** Returns the table for a curve, size + 2 entries so interpolating at
+        the very end stays in bounds. */
+    static const float* get (const FadeCurve curve, const bool rising) noexcept {
+        static const FadeTables tables;
+        return tables.shapes[curve == FadeCurve::equalPower ? (rising ? 1 : 2) : 0];
+    }
+
+private:
+    float shapes[3][size + 2];
+
+    FadeTables() noexcept {
+        const double halfPi = juce::MathConstants<double>::halfPi;
+        for (int i = 0; i < size + 2; ++i) {
+            const double x = juce::jmin (1.0, (double) i / size);
+            shapes[0][i] = (float) x;
+            shapes[1][i] = (float) std::sin (x * halfPi);
+            shapes[2][i] = (float) (1.0 - std::cos (x * halfPi));
+        }
+    }
+};
+
+//==============================================================================
+/** The gain of one filter, faded in and out as it's switched.
+
+    A fade runs from whatever gain the filter was at to the target, so one
+    started over another carries on from where that had got to. Blocks of
+    gains are rendered from FadeTables with one division per block.
+*/
+class GainFade {
+public:
+    GainFade() = default;
+
+    void start (const float target, const int numSamples, const FadeCurve curveToUse) noexcept {
+        startGain = gain;
+        targetGain = target;
+        curve = curveToUse;
+        position = 0;
+        length = juce::jmax (0, numSamples);
+        if (length == 0)
+            gain = targetGain;
+    }
+
+    bool isFading() const noexcept { return position < length; }
+    int getNumSamplesRemaining() const noexcept { return length - position; }
+    float getTargetGain() const noexcept { return targetGain; }
+
+    /** Returns true once a fade out has finished, when the filter can be left out. */
+    bool isSilent() const noexcept { return ! isFading() && targetGain <= 0.0f; }
+
+    /** Once the fade is over, returns the gain it settled on. */
+    float settle() const noexcept {
+        jassert (! isFading());
+        return targetGain;
+    }
+
+    /** Advances the fade over a block, writing the gain for each sample. */
+    template <typename SampleType>
+    void render (SampleType* gains, const int numSamples) noexcept {
+        int i = 0;
+
+        if (isFading() && numSamples > 0) {
+            const int numFading = juce::jmin (numSamples, length - position);
+            const float* const table = FadeTables::get (curve, targetGain > startGain);
+            const float range = targetGain - startGain;
+            const double step = (double) FadeTables::size / length;
+            double phase = position * step;
+
+            for (; i < numFading; ++i) {
+                const int index = (int) phase;
+                const float fraction = (float) (phase - index);
+                const float shape = table[index] + fraction * (table[index + 1] - table[index]);
+                gains[i] = (SampleType) (startGain + range * shape);
+                phase += step;
+            }
+
+            position += numFading;
+            gain = isFading() ? (float) gains[i - 1] : targetGain;
+        }
+
+        for (; i < numSamples; ++i)
+            gains[i] = (SampleType) gain;
+    }
+
+private:
+    float startGain { 1.0f };
+    float targetGain { 1.0f };
+    float gain { 1.0f };
+    int position { 0 };
+    int length { 0 };
+    FadeCurve curve { FadeCurve::equalPower };
+};
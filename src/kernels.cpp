@@ -0,0 +1,79 @@
+// Copyright (C) 2015-2025  Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#include <juce_core/juce_core.h>
+
+#include "kernels.hpp"
+
+namespace kernels {
+
+static constexpr Dispatch baselineDispatch = makeDispatch (Isa::baseline);
+
+const Dispatch* getDispatch (const Isa isa) noexcept {
+    switch (isa) {
+        case Isa::scalar:
+            return detail::getScalarDispatch();
+        case Isa::baseline:
+            return &baselineDispatch;
+#if JUCE_INTEL
+        case Isa::avx2:
+            if (juce::SystemStats::hasAVX2() && juce::SystemStats::hasFMA3())
+                return detail::getAvx2Dispatch();
+            break;
+        case Isa::avx512:
+            if (juce::SystemStats::hasAVX512F() && juce::SystemStats::hasAVX512VL() && juce::SystemStats::hasAVX512DQ())
+                return detail::getAvx512Dispatch();
+            break;
+#else
+        case Isa::avx2:
+        case Isa::avx512:
+            break;
+#endif
+        case Isa::numIsas:
+            break;
+    }
+
+    return nullptr;
+}
+
+Isa getPreferredIsa() {
+    const juce::String requested = juce::SystemStats::getEnvironmentVariable ("SYNCROBOVERB_KERNELS", {});
+
+    if (requested.isNotEmpty()) {
+        for (int i = 0; i < (int) Isa::numIsas; ++i)
+            if (requested.equalsIgnoreCase (getIsaName ((Isa) i)) && getDispatch ((Isa) i) != nullptr)
+                return (Isa) i;
+        jassertfalse; // unknown or unsupported instruction set
+    }
+
+    for (int i = (int) Isa::numIsas; --i > (int) Isa::baseline;)
+        if (getDispatch ((Isa) i) != nullptr)
+            return (Isa) i;
+
+    return Isa::baseline;
+}
+
+const char* getIsaName (const Isa isa) noexcept {
+    switch (isa) {
+        case Isa::scalar:
+            return "scalar";
+        case Isa::baseline:
+#if JUCE_ARM
+            return "NEON";
+#elif JUCE_INTEL
+            return "SSE2";
+#else
+            return "baseline";
+#endif
+        case Isa::avx2:
+            return "AVX2";
+        case Isa::avx512:
+            return "AVX-512";
+        case Isa::numIsas:
+            break;
+    }
+
+    return "";
+}
+
+} // namespace kernels
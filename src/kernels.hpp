@@ -0,0 +1,571 @@
+// Copyright (C) 2015-2025  Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#ifndef SYNCROBOVERB_KERNEL_ISA
+ #define SYNCROBOVERB_KERNEL_ISA baseline
+#endif
+
+/** Time-axis kernels for a single comb or allpass line.
+
+    Every comb delay is at least 64 samples and every allpass delay at least
+    225 (at 44.1kHz), so inside a chunk no longer than the delay the taps never
+    depend on samples written in the same chunk. The allpass then has no serial
+    dependency at all, and the comb is left with only its one-pole damping state,
+    which is resolved with a parallel prefix scan over groups of scanWidth samples.
+
+    Callers must keep numSamples <= the line's delay and pass contiguous spans.
+
+    Coefficients are taken either as per-sample arrays or, once nothing is
+    moving, as a Constant which the compiler keeps in a register.
+
+    There are no denormal guards in the loops: callers run them with
+    flush-to-zero and denormals-are-zero set, see Processor::process().
+
+    The kernels are compiled once per instruction set level, each build in its
+    own inline namespace named by SYNCROBOVERB_KERNEL_ISA (see kernels_avx2.cpp
+    and friends), and the processor calls them through the Dispatch table of
+    the build picked at runtime.
+*/
+namespace kernels {
+
+/** Instruction set levels the kernels are built for. baseline is whatever the
+    whole plugin targets: SSE2 on x86-64, NEON on arm64. scalar is baseline
+    with auto-vectorization turned off, kept as a reference. */
+enum class Isa { scalar = 0, baseline, avx2, avx512, numIsas };
+
+/** A delay line sample stored as bfloat16, i.e. the top half of a float. */
+struct BFloat16 {
+    std::uint16_t bits;
+};
+
+/** Entry points into one build of the kernels, for one sample type and one
+    delay line storage type. Coeff is const SampleType* for per-sample
+    coefficients, or SampleType for a value held over the whole block.
+
+    Everything outside the inline namespace is shared between the builds, so
+    it must stay free of function bodies: an inline function compiled with a
+    wider instruction set could otherwise be the one the linker keeps. */
+template <typename SampleType, typename Coeff, typename Stored>
+struct KernelSet {
+    SampleType (*combChunk) (const Stored* taps, Stored* writes, const SampleType* input,
+                             Coeff damp, Coeff feedback, Coeff gains,
+                             SampleType* accumulator, int numSamples, SampleType state);
+    SampleType (*combLoopChunk) (const Stored* taps, Coeff gains, SampleType* accumulator, int numSamples,
+                                 SampleType state);
+    void (*allPassChunk) (const Stored* taps, Stored* writes, SampleType* samples, Coeff gains, int numSamples);
+    void (*allPassPairChunk) (const Stored* tapsL, Stored* writesL, const Stored* tapsR, Stored* writesR,
+                              SampleType* wetL, SampleType* wetR, Coeff gainsL, Coeff gainsR, int numSamples);
+    void (*allPassPairMixChunk) (const Stored* tapsL, Stored* writesL, const Stored* tapsR, Stored* writesR,
+                                 const SampleType* wetL, const SampleType* wetR, Coeff gainsL, Coeff gainsR,
+                                 SampleType* left, SampleType* right, Coeff dry, Coeff wet1, Coeff wet2, int numSamples);
+    void (*allPassMixChunk) (const Stored* taps, Stored* writes, const SampleType* wet, Coeff gains,
+                             SampleType* samples, Coeff dry, Coeff wetGain, int numSamples);
+    void (*stereoMix) (const SampleType* wetL, const SampleType* wetR, SampleType* left, SampleType* right,
+                       Coeff dry, Coeff wet1, Coeff wet2, int numSamples);
+    void (*monoMix) (const SampleType* wet, SampleType* samples, Coeff dry, Coeff wetGain, int numSamples);
+};
+
+/** The kernels of one build for one storage type. */
+template <typename Stored>
+struct StorageKernels {
+    KernelSet<float, const float*, Stored> floatMoving;
+    KernelSet<float, float, Stored> floatSteady;
+    KernelSet<double, const double*, Stored> doubleMoving;
+    KernelSet<double, double, Stored> doubleSteady;
+};
+
+/** Every kernel of one build. */
+struct Dispatch {
+    Isa isa;
+    StorageKernels<float> float32;
+    StorageKernels<BFloat16> bfloat16;
+    StorageKernels<std::int16_t> int16;
+};
+
+/** Returns the build for an instruction set, or nullptr if the binary wasn't
+    built with it or the CPU doesn't support it. */
+const Dispatch* getDispatch (Isa isa) noexcept;
+
+/** Returns the widest instruction set the CPU runs. For debugging, setting the
+    SYNCROBOVERB_KERNELS environment variable to one of the getIsaName() names,
+    e.g. "scalar", picks that build instead. */
+Isa getPreferredIsa();
+
+const char* getIsaName (Isa isa) noexcept;
+
+namespace detail {
+const Dispatch* getScalarDispatch() noexcept;
+const Dispatch* getAvx2Dispatch() noexcept;
+const Dispatch* getAvx512Dispatch() noexcept;
+} // namespace detail
+
+//==============================================================================
+inline namespace SYNCROBOVERB_KERNEL_ISA {
+
+enum { scanWidth = 8 };
+
+/** Converts delay line samples to and from the type they're stored as. */
+template <typename Stored>
+struct Storage;
+
+template <>
+struct Storage<float> {
+    static float load (const float sample) noexcept { return sample; }
+
+    template <typename SampleType>
+    static float store (const SampleType value) noexcept { return (float) value; }
+};
+
+/** Rounds to nearest even. Loading is exact, so a frozen loop doesn't drift. */
+template <>
+struct Storage<BFloat16> {
+    static float load (const BFloat16 sample) noexcept {
+        const std::uint32_t bits = (std::uint32_t) sample.bits << 16;
+        float value;
+        std::memcpy (&value, &bits, sizeof (value));
+        return value;
+    }
+
+    template <typename SampleType>
+    static BFloat16 store (const SampleType value) noexcept {
+        const float narrowed = (float) value;
+        std::uint32_t bits;
+        std::memcpy (&bits, &narrowed, sizeof (bits));
+        bits += 0x7fffu + ((bits >> 16) & 1u);
+        return { (std::uint16_t) (bits >> 16) };
+    }
+};
+
+/** Fixed point with fullScale of headroom. A comb line driven at resonance
+    by full scale input in the largest room peaks around 1.5, so only input
+    hotter than full scale clips it. The allpass lines take the sum of every
+    comb and would clip, so they're never stored like this. */
+template <>
+struct Storage<std::int16_t> {
+    static constexpr float fullScale = 2.0f;
+
+    static float load (const std::int16_t sample) noexcept { return (float) sample * (fullScale / 32768.0f); }
+
+    template <typename SampleType>
+    static std::int16_t store (const SampleType value) noexcept {
+        const float scaled = (float) value * (32768.0f / fullScale);
+        // truncated toward zero: rounded to nearest, a comb's feedback holds
+        // a few steps forever and the tail never dies away
+        const int truncated = (int) scaled;
+        return (std::int16_t) (truncated < -32768 ? -32768 : (truncated > 32767 ? 32767 : truncated));
+    }
+};
+
+/** A coefficient that holds still for the whole block. It indexes and offsets
+    like a pointer, so the same kernels accept either one. */
+template <typename SampleType>
+struct Constant {
+    SampleType value;
+
+    SampleType operator[] (int) const noexcept { return value; }
+    Constant operator+ (int) const noexcept { return *this; }
+};
+
+/** Runs a comb line over a chunk, adding its output (times gains) to accumulator.
+    Returns the damping state to carry into the next chunk. */
+template <typename SampleType, typename Stored, typename Coeffs, typename Gains>
+SampleType combChunk (const Stored* taps, Stored* writes, const SampleType* input,
+                      Coeffs damp, Coeffs feedback, Gains gains,
+                      SampleType* accumulator, const int numSamples, SampleType state) noexcept {
+    int i = 0;
+
+    for (; i + scanWidth <= numSamples; i += scanWidth) {
+        // state[j] = b[j] + m[j] * state[j - 1] with b = tap * (1 - damp) and m = damp.
+        // Each pass composes every element with the one `offset` samples before it;
+        // padding with the identity (b = 0, m = 1) keeps the passes free of branches.
+        alignas (64) SampleType tap[scanWidth];
+        alignas (64) SampleType b[2 * scanWidth];
+        alignas (64) SampleType m[2 * scanWidth];
+
+        for (int j = 0; j < scanWidth; ++j) {
+            tap[j] = Storage<Stored>::load (taps[i + j]);
+            b[j] = SampleType (0);
+            m[j] = SampleType (1);
+            b[scanWidth + j] = tap[j] * (SampleType (1) - damp[i + j]);
+            m[scanWidth + j] = damp[i + j];
+        }
+
+        for (int offset = 1; offset < scanWidth; offset *= 2) {
+            alignas (64) SampleType nb[scanWidth], nm[scanWidth];
+            for (int j = 0; j < scanWidth; ++j) {
+                nb[j] = b[scanWidth + j] + m[scanWidth + j] * b[scanWidth + j - offset];
+                nm[j] = m[scanWidth + j] * m[scanWidth + j - offset];
+            }
+
+            for (int j = 0; j < scanWidth; ++j) {
+                b[scanWidth + j] = nb[j];
+                m[scanWidth + j] = nm[j];
+            }
+        }
+
+        for (int j = 0; j < scanWidth; ++j) {
+            const SampleType filtered = b[scanWidth + j] + m[scanWidth + j] * state;
+            const SampleType temp = input[i + j] + (filtered * feedback[i + j]);
+            writes[i + j] = Storage<Stored>::store (temp);
+            accumulator[i + j] += tap[j] * gains[i + j];
+        }
+
+        state = b[2 * scanWidth - 1] + m[2 * scanWidth - 1] * state;
+    }
+
+    for (; i < numSamples; ++i) {
+        const SampleType output = Storage<Stored>::load (taps[i]);
+        state = (output * (SampleType (1) - damp[i])) + (state * damp[i]);
+
+        const SampleType temp = input[i] + (state * feedback[i]);
+        writes[i] = Storage<Stored>::store (temp);
+
+        accumulator[i] += output * gains[i];
+    }
+
+    return state;
+}
+
+/** combChunk() for a block where damping and feedback hold still. The scan
+    multipliers are then just powers of the damping, worked out once per chunk. */
+template <typename SampleType, typename Stored, typename Gains>
+SampleType combChunk (const Stored* taps, Stored* writes, const SampleType* input,
+                      const Constant<SampleType> damp, const Constant<SampleType> feedback, Gains gains,
+                      SampleType* accumulator, const int numSamples, SampleType state) noexcept {
+    const SampleType d = damp.value, fb = feedback.value, g = SampleType (1) - d;
+
+    alignas (64) SampleType powers[scanWidth]; // d^(j + 1), what state carries into sample j
+    SampleType stride[scanWidth];              // d^offset for each pass
+    powers[0] = d;
+    for (int j = 1; j < scanWidth; ++j)
+        powers[j] = powers[j - 1] * d;
+    for (int offset = 1; offset < scanWidth; offset *= 2)
+        stride[offset] = powers[offset - 1];
+
+    int i = 0;
+
+    for (; i + scanWidth <= numSamples; i += scanWidth) {
+        alignas (64) SampleType tap[scanWidth];
+        alignas (64) SampleType b[2 * scanWidth];
+
+        for (int j = 0; j < scanWidth; ++j) {
+            tap[j] = Storage<Stored>::load (taps[i + j]);
+            b[j] = SampleType (0);
+            b[scanWidth + j] = tap[j] * g;
+        }
+
+        for (int offset = 1; offset < scanWidth; offset *= 2) {
+            alignas (64) SampleType nb[scanWidth];
+            for (int j = 0; j < scanWidth; ++j)
+                nb[j] = b[scanWidth + j] + stride[offset] * b[scanWidth + j - offset];
+            for (int j = 0; j < scanWidth; ++j)
+                b[scanWidth + j] = nb[j];
+        }
+
+        for (int j = 0; j < scanWidth; ++j) {
+            const SampleType filtered = b[scanWidth + j] + powers[j] * state;
+            const SampleType temp = input[i + j] + (filtered * fb);
+            writes[i + j] = Storage<Stored>::store (temp);
+            accumulator[i + j] += tap[j] * gains[i + j];
+        }
+
+        state = b[2 * scanWidth - 1] + powers[scanWidth - 1] * state;
+    }
+
+    for (; i < numSamples; ++i) {
+        const SampleType output = Storage<Stored>::load (taps[i]);
+        state = (output * g) + (state * d);
+
+        const SampleType temp = input[i] + (state * fb);
+        writes[i] = Storage<Stored>::store (temp);
+
+        accumulator[i] += output * gains[i];
+    }
+
+    return state;
+}
+
+/** combChunk() for a frozen comb: with no input, no damping and unity
+    feedback the line only recirculates what it holds, so the caller loops
+    over it read-only and all that's left is the output gain. Returns the
+    damping state, which while frozen is just the last tap. */
+template <typename SampleType, typename Stored, typename Gains>
+SampleType combLoopChunk (const Stored* taps, Gains gains, SampleType* accumulator, const int numSamples,
+                          const SampleType state) noexcept {
+    for (int i = 0; i < numSamples; ++i)
+        accumulator[i] += Storage<Stored>::load (taps[i]) * gains[i];
+
+    return numSamples > 0 ? SampleType (Storage<Stored>::load (taps[numSamples - 1])) : state;
+}
+
+/** Runs an allpass line in place over a chunk. The gain crossfades the
+    stage's output with its input, so at zero the stage is bypassed rather
+    than muted and can be faded in and out of the chain. */
+template <typename SampleType, typename Stored, typename Gains>
+void allPassChunk (const Stored* taps, Stored* writes, SampleType* samples,
+                   Gains gains, const int numSamples) noexcept {
+    for (int i = 0; i < numSamples; ++i) {
+        const SampleType input = samples[i];
+        const SampleType bufferedValue = Storage<Stored>::load (taps[i]);
+        writes[i] = Storage<Stored>::store (input + (bufferedValue * SampleType (0.5)));
+        samples[i] = (bufferedValue - input) * gains[i] + input * (SampleType (1) - gains[i]);
+    }
+}
+
+//==============================================================================
+/** The host buffers and gains of the final wet/dry/width matrix. */
+template <typename SampleType, typename Coeffs = const SampleType*>
+struct StereoMix {
+    SampleType* left;
+    SampleType* right;
+    Coeffs dry;
+    Coeffs wet1;
+    Coeffs wet2;
+
+    StereoMix at (const int offset) const noexcept {
+        return { left + offset, right + offset, dry + offset, wet1 + offset, wet2 + offset };
+    }
+};
+
+template <typename SampleType, typename Coeffs = const SampleType*>
+struct MonoMix {
+    SampleType* samples;
+    Coeffs dry;
+    Coeffs wet;
+
+    MonoMix at (const int offset) const noexcept {
+        return { samples + offset, dry + offset, wet + offset };
+    }
+};
+
+/** Applies the output matrix to the wet signal. */
+template <typename SampleType, typename Coeffs>
+void stereoMix (const SampleType* wetL, const SampleType* wetR, const StereoMix<SampleType, Coeffs>& mix,
+                const int numSamples) noexcept {
+    for (int i = 0; i < numSamples; ++i) {
+        const SampleType l = wetL[i] * mix.wet1[i] + wetR[i] * mix.wet2[i] + mix.left[i] * mix.dry[i];
+        const SampleType r = wetR[i] * mix.wet1[i] + wetL[i] * mix.wet2[i] + mix.right[i] * mix.dry[i];
+        mix.left[i] = l;
+        mix.right[i] = r;
+    }
+}
+
+template <typename SampleType, typename Coeffs>
+void monoMix (const SampleType* wet, const MonoMix<SampleType, Coeffs>& mix, const int numSamples) noexcept {
+    for (int i = 0; i < numSamples; ++i)
+        mix.samples[i] = wet[i] * mix.wet[i] + mix.samples[i] * mix.dry[i];
+}
+
+/** Runs the left and right lines of one allpass stage together, so each
+    iteration works on an L/R pair. */
+template <typename SampleType, typename Stored, typename Gains>
+void allPassPairChunk (const Stored* tapsL, Stored* writesL, const Stored* tapsR, Stored* writesR,
+                       SampleType* wetL, SampleType* wetR, Gains gainsL, Gains gainsR,
+                       const int numSamples) noexcept {
+    for (int i = 0; i < numSamples; ++i) {
+        const SampleType inL = wetL[i], inR = wetR[i];
+        const SampleType bufferedL = Storage<Stored>::load (tapsL[i]);
+        const SampleType bufferedR = Storage<Stored>::load (tapsR[i]);
+        writesL[i] = Storage<Stored>::store (inL + (bufferedL * SampleType (0.5)));
+        writesR[i] = Storage<Stored>::store (inR + (bufferedR * SampleType (0.5)));
+        wetL[i] = (bufferedL - inL) * gainsL[i] + inL * (SampleType (1) - gainsL[i]);
+        wetR[i] = (bufferedR - inR) * gainsR[i] + inR * (SampleType (1) - gainsR[i]);
+    }
+}
+
+/** As allPassPairChunk(), for the last stage: the output matrix is applied in
+    the same pass instead of writing the wet signal back. */
+template <typename SampleType, typename Stored, typename Gains, typename Coeffs>
+void allPassPairMixChunk (const Stored* tapsL, Stored* writesL, const Stored* tapsR, Stored* writesR,
+                          const SampleType* wetL, const SampleType* wetR, Gains gainsL, Gains gainsR,
+                          const StereoMix<SampleType, Coeffs>& mix, const int numSamples) noexcept {
+    for (int i = 0; i < numSamples; ++i) {
+        const SampleType inL = wetL[i], inR = wetR[i];
+        const SampleType bufferedL = Storage<Stored>::load (tapsL[i]);
+        const SampleType bufferedR = Storage<Stored>::load (tapsR[i]);
+        writesL[i] = Storage<Stored>::store (inL + (bufferedL * SampleType (0.5)));
+        writesR[i] = Storage<Stored>::store (inR + (bufferedR * SampleType (0.5)));
+        const SampleType outL = (bufferedL - inL) * gainsL[i] + inL * (SampleType (1) - gainsL[i]);
+        const SampleType outR = (bufferedR - inR) * gainsR[i] + inR * (SampleType (1) - gainsR[i]);
+        const SampleType l = outL * mix.wet1[i] + outR * mix.wet2[i] + mix.left[i] * mix.dry[i];
+        const SampleType r = outR * mix.wet1[i] + outL * mix.wet2[i] + mix.right[i] * mix.dry[i];
+        mix.left[i] = l;
+        mix.right[i] = r;
+    }
+}
+
+/** Mono counterpart of allPassPairMixChunk(). */
+template <typename SampleType, typename Stored, typename Gains, typename Coeffs>
+void allPassMixChunk (const Stored* taps, Stored* writes, const SampleType* wet, Gains gains,
+                      const MonoMix<SampleType, Coeffs>& mix, const int numSamples) noexcept {
+    for (int i = 0; i < numSamples; ++i) {
+        const SampleType input = wet[i];
+        const SampleType bufferedValue = Storage<Stored>::load (taps[i]);
+        writes[i] = Storage<Stored>::store (input + (bufferedValue * SampleType (0.5)));
+        const SampleType output = (bufferedValue - input) * gains[i] + input * (SampleType (1) - gains[i]);
+        mix.samples[i] = output * mix.wet[i] + mix.samples[i] * mix.dry[i];
+    }
+}
+
+//==============================================================================
+inline const float* toCoeff (const float* values) noexcept { return values; }
+inline const double* toCoeff (const double* values) noexcept { return values; }
+inline Constant<float> toCoeff (const float value) noexcept { return { value }; }
+inline Constant<double> toCoeff (const double value) noexcept { return { value }; }
+
+/** Fills in a KernelSet with this build's kernels. */
+template <typename SampleType, typename Coeff, typename Stored>
+constexpr KernelSet<SampleType, Coeff, Stored> makeKernelSet() noexcept {
+    using Mono = MonoMix<SampleType, decltype (toCoeff (Coeff()))>;
+    using Stereo = StereoMix<SampleType, decltype (toCoeff (Coeff()))>;
+
+    KernelSet<SampleType, Coeff, Stored> set {};
+    set.combChunk = [] (const Stored* taps, Stored* writes, const SampleType* input, Coeff damp, Coeff feedback,
+                        Coeff gains, SampleType* accumulator, int numSamples, SampleType state) {
+        return combChunk (taps, writes, input, toCoeff (damp), toCoeff (feedback), toCoeff (gains),
+                          accumulator, numSamples, state);
+    };
+    set.combLoopChunk = [] (const Stored* taps, Coeff gains, SampleType* accumulator, int numSamples, SampleType state) {
+        return combLoopChunk (taps, toCoeff (gains), accumulator, numSamples, state);
+    };
+    set.allPassChunk = [] (const Stored* taps, Stored* writes, SampleType* samples, Coeff gains, int numSamples) {
+        allPassChunk (taps, writes, samples, toCoeff (gains), numSamples);
+    };
+    set.allPassPairChunk = [] (const Stored* tapsL, Stored* writesL, const Stored* tapsR, Stored* writesR,
+                               SampleType* wetL, SampleType* wetR, Coeff gainsL, Coeff gainsR, int numSamples) {
+        allPassPairChunk (tapsL, writesL, tapsR, writesR, wetL, wetR, toCoeff (gainsL), toCoeff (gainsR), numSamples);
+    };
+    set.allPassPairMixChunk = [] (const Stored* tapsL, Stored* writesL, const Stored* tapsR, Stored* writesR,
+                                  const SampleType* wetL, const SampleType* wetR, Coeff gainsL, Coeff gainsR,
+                                  SampleType* left, SampleType* right, Coeff dry, Coeff wet1, Coeff wet2, int numSamples) {
+        const Stereo mix { left, right, toCoeff (dry), toCoeff (wet1), toCoeff (wet2) };
+        allPassPairMixChunk (tapsL, writesL, tapsR, writesR, wetL, wetR, toCoeff (gainsL), toCoeff (gainsR), mix, numSamples);
+    };
+    set.allPassMixChunk = [] (const Stored* taps, Stored* writes, const SampleType* wet, Coeff gains,
+                              SampleType* samples, Coeff dry, Coeff wetGain, int numSamples) {
+        const Mono mix { samples, toCoeff (dry), toCoeff (wetGain) };
+        allPassMixChunk (taps, writes, wet, toCoeff (gains), mix, numSamples);
+    };
+    set.stereoMix = [] (const SampleType* wetL, const SampleType* wetR, SampleType* left, SampleType* right,
+                        Coeff dry, Coeff wet1, Coeff wet2, int numSamples) {
+        const Stereo mix { left, right, toCoeff (dry), toCoeff (wet1), toCoeff (wet2) };
+        stereoMix (wetL, wetR, mix, numSamples);
+    };
+    set.monoMix = [] (const SampleType* wet, SampleType* samples, Coeff dry, Coeff wetGain, int numSamples) {
+        const Mono mix { samples, toCoeff (dry), toCoeff (wetGain) };
+        monoMix (wet, mix, numSamples);
+    };
+    return set;
+}
+
+template <typename Stored>
+constexpr StorageKernels<Stored> makeStorageKernels() noexcept {
+    return { makeKernelSet<float, const float*, Stored>(),
+             makeKernelSet<float, float, Stored>(),
+             makeKernelSet<double, const double*, Stored>(),
+             makeKernelSet<double, double, Stored>() };
+}
+
+constexpr Dispatch makeDispatch (const Isa isa) noexcept {
+    return { isa,
+             makeStorageKernels<float>(),
+             makeStorageKernels<BFloat16>(),
+             makeStorageKernels<std::int16_t>() };
+}
+
+//==============================================================================
+/** Forwards kernel calls to the selected build, taking the same arguments as
+    the kernel templates above. */
+class Dispatcher {
+public:
+    Dispatcher() noexcept : dispatch (getDispatch (Isa::baseline)) {}
+    explicit Dispatcher (const Dispatch& d) noexcept : dispatch (&d) {}
+
+    Isa getIsa() const noexcept { return dispatch->isa; }
+
+    template <typename SampleType, typename Stored, typename Coeffs, typename Gains>
+    SampleType combChunk (const Stored* taps, Stored* writes, const SampleType* input,
+                          Coeffs damp, Coeffs feedback, Gains gains,
+                          SampleType* accumulator, const int numSamples, SampleType state) const noexcept {
+        return setFor (storageFor (taps), gains).combChunk (taps, writes, input, arg (damp), arg (feedback), arg (gains),
+                                                     accumulator, numSamples, state);
+    }
+
+    template <typename SampleType, typename Stored, typename Gains>
+    SampleType combLoopChunk (const Stored* taps, Gains gains, SampleType* accumulator, const int numSamples,
+                              SampleType state) const noexcept {
+        return setFor (storageFor (taps), gains).combLoopChunk (taps, arg (gains), accumulator, numSamples, state);
+    }
+
+    template <typename SampleType, typename Stored, typename Gains>
+    void allPassChunk (const Stored* taps, Stored* writes, SampleType* samples, Gains gains,
+                       const int numSamples) const noexcept {
+        setFor (storageFor (taps), gains).allPassChunk (taps, writes, samples, arg (gains), numSamples);
+    }
+
+    template <typename SampleType, typename Stored, typename Gains>
+    void allPassPairChunk (const Stored* tapsL, Stored* writesL, const Stored* tapsR, Stored* writesR,
+                           SampleType* wetL, SampleType* wetR, Gains gainsL, Gains gainsR,
+                           const int numSamples) const noexcept {
+        setFor (storageFor (tapsL), gainsL).allPassPairChunk (tapsL, writesL, tapsR, writesR, wetL, wetR,
+                                                      arg (gainsL), arg (gainsR), numSamples);
+    }
+
+    template <typename SampleType, typename Stored, typename Gains, typename Coeffs>
+    void allPassPairMixChunk (const Stored* tapsL, Stored* writesL, const Stored* tapsR, Stored* writesR,
+                              const SampleType* wetL, const SampleType* wetR, Gains gainsL, Gains gainsR,
+                              const StereoMix<SampleType, Coeffs>& mix, const int numSamples) const noexcept {
+        setFor (storageFor (tapsL), gainsL).allPassPairMixChunk (tapsL, writesL, tapsR, writesR, wetL, wetR,
+                                                         arg (gainsL), arg (gainsR), mix.left, mix.right,
+                                                         arg (mix.dry), arg (mix.wet1), arg (mix.wet2), numSamples);
+    }
+
+    template <typename SampleType, typename Stored, typename Gains, typename Coeffs>
+    void allPassMixChunk (const Stored* taps, Stored* writes, const SampleType* wet, Gains gains,
+                          const MonoMix<SampleType, Coeffs>& mix, const int numSamples) const noexcept {
+        setFor (storageFor (taps), gains).allPassMixChunk (taps, writes, wet, arg (gains), mix.samples,
+                                                    arg (mix.dry), arg (mix.wet), numSamples);
+    }
+
+    template <typename SampleType, typename Coeffs>
+    void stereoMix (const SampleType* wetL, const SampleType* wetR, const StereoMix<SampleType, Coeffs>& mix,
+                    const int numSamples) const noexcept {
+        setFor (dispatch->float32, mix.dry).stereoMix (wetL, wetR, mix.left, mix.right,
+                                                arg (mix.dry), arg (mix.wet1), arg (mix.wet2), numSamples);
+    }
+
+    template <typename SampleType, typename Coeffs>
+    void monoMix (const SampleType* wet, const MonoMix<SampleType, Coeffs>& mix, const int numSamples) const noexcept {
+        setFor (dispatch->float32, mix.dry).monoMix (wet, mix.samples, arg (mix.dry), arg (mix.wet), numSamples);
+    }
+
+private:
+    const Dispatch* dispatch;
+
+    template <typename SampleType>
+    static const SampleType* arg (const SampleType* values) noexcept { return values; }
+    template <typename SampleType>
+    static SampleType arg (const Constant<SampleType> value) noexcept { return value.value; }
+
+    const StorageKernels<float>& storageFor (const float*) const noexcept { return dispatch->float32; }
+    const StorageKernels<BFloat16>& storageFor (const BFloat16*) const noexcept { return dispatch->bfloat16; }
+    const StorageKernels<std::int16_t>& storageFor (const std::int16_t*) const noexcept { return dispatch->int16; }
+
+    template <typename Stored>
+    static const KernelSet<float, const float*, Stored>& setFor (const StorageKernels<Stored>& k, const float*) noexcept { return k.floatMoving; }
+    template <typename Stored>
+    static const KernelSet<float, float, Stored>& setFor (const StorageKernels<Stored>& k, Constant<float>) noexcept { return k.floatSteady; }
+    template <typename Stored>
+    static const KernelSet<double, const double*, Stored>& setFor (const StorageKernels<Stored>& k, const double*) noexcept { return k.doubleMoving; }
+    template <typename Stored>
+    static const KernelSet<double, double, Stored>& setFor (const StorageKernels<Stored>& k, Constant<double>) noexcept { return k.doubleSteady; }
+};
+
+} // namespace SYNCROBOVERB_KERNEL_ISA
+} // namespace kernels
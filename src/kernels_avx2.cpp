@@ -0,0 +1,22 @@
+// Copyright (C) 2015-2025  Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+// The AVX2 + FMA build of the kernels. CMakeLists.txt only adds the flags on
+// x86-64; anywhere else this file builds nothing and the build isn't offered.
+
+#if defined(__AVX2__)
+ #define SYNCROBOVERB_KERNEL_ISA avx2
+#endif
+
+#include "kernels.hpp"
+
+namespace kernels {
+
+#if defined(__AVX2__)
+static constexpr Dispatch avx2Dispatch = makeDispatch (Isa::avx2);
+const Dispatch* detail::getAvx2Dispatch() noexcept { return &avx2Dispatch; }
+#else
+const Dispatch* detail::getAvx2Dispatch() noexcept { return nullptr; }
+#endif
+
+} // namespace kernels
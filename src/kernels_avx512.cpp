@@ -0,0 +1,22 @@
+// Copyright (C) 2015-2025  Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+// The AVX-512 build of the kernels. CMakeLists.txt only adds the flags on
+// x86-64; anywhere else this file builds nothing and the build isn't offered.
+
+#if defined(__AVX512F__) && defined(__AVX512VL__) && defined(__AVX512DQ__)
+ #define SYNCROBOVERB_KERNEL_ISA avx512
+#endif
+
+#include "kernels.hpp"
+
+namespace kernels {
+
+#if defined(__AVX512F__) && defined(__AVX512VL__) && defined(__AVX512DQ__)
+static constexpr Dispatch avx512Dispatch = makeDispatch (Isa::avx512);
+const Dispatch* detail::getAvx512Dispatch() noexcept { return &avx512Dispatch; }
+#else
+const Dispatch* detail::getAvx512Dispatch() noexcept { return nullptr; }
+#endif
+
+} // namespace kernels
@@ -0,0 +1,17 @@
+// Copyright (C) 2015-2025  Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+// The reference build of the kernels. CMakeLists.txt turns auto-vectorization
+// off for this file on GCC and Clang, so these are the kernels exactly as
+// written; MSVC has no such switch.
+
+#define SYNCROBOVERB_KERNEL_ISA scalar
+#include "kernels.hpp"
+
+namespace kernels {
+
+static constexpr Dispatch scalarDispatch = makeDispatch (Isa::scalar);
+
+const Dispatch* detail::getScalarDispatch() noexcept { return &scalarDispatch; }
+
+} // namespace kernels
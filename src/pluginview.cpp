@@ -11,8 +11,6 @@ namespace syncroboverb {
 //==============================================================================
 PluginView::PluginView() {
     //[Constructor_pre] You can add your own custom stuff here..
-    combs.setRange (0, 8, false);
-    allpasses.setRange (0, 4, false);
     //[/Constructor_pre]
 
     sphere.reset (new SphereScope());
@@ -387,6 +385,127 @@ PluginView::PluginView() {
     crossfadeRateValueLabel->setColour (TextEditor::backgroundColourId, Colour (0x00000000));
     crossfadeRateValueLabel->setBounds (380, 220, 56, 16);
 
+    fadeCurve.reset (new SkinDial ("fadeCurve"));
+    addAndMakeVisible (fadeCurve.get());
+    fadeCurve->setRange (0, 1, 1);
+    fadeCurve->setSliderStyle (Slider::RotaryVerticalDrag);
+    fadeCurve->setTextBoxStyle (Slider::NoTextBox, true, 80, 20);
+    fadeCurve->addListener (this);
+    fadeCurve->setBounds (460, 146, 56, 56);
+
+    fadeCurveLabel.reset (new Label ("fadeCurveLabel", TRANS ("Curve")));
+    addAndMakeVisible (fadeCurveLabel.get());
+    fadeCurveLabel->setFont (Font (FontOptions (12.00f, Font::plain)).withTypefaceStyle ("Regular"));
+    fadeCurveLabel->setJustificationType (Justification::centred);
+    fadeCurveLabel->setEditable (false, false, false);
+    fadeCurveLabel->setColour (Label::textColourId, Colour (0xe4dfddaf));
+    fadeCurveLabel->setColour (TextEditor::textColourId, Colours::black);
+    fadeCurveLabel->setColour (TextEditor::backgroundColourId, Colour (0x00000000));
+    fadeCurveLabel->setBounds (460, 204, 56, 24);
+
+    fadeCurveValueLabel.reset (new Label ("fadeCurveValueLabel", TRANS ("EQUAL POWER")));
+    addAndMakeVisible (fadeCurveValueLabel.get());
+    fadeCurveValueLabel->setFont (Font (FontOptions (10.00f, Font::plain)).withTypefaceStyle ("Regular"));
+    fadeCurveValueLabel->setJustificationType (Justification::centred);
+    fadeCurveValueLabel->setEditable (false, false, false);
+    fadeCurveValueLabel->setColour (Label::textColourId, Colour (0xe4dfddaf));
+    fadeCurveValueLabel->setColour (TextEditor::textColourId, Colours::black);
+    fadeCurveValueLabel->setColour (TextEditor::backgroundColourId, Colour (0x00000000));
+    fadeCurveValueLabel->setBounds (448, 220, 80, 16);
+
+    // Engine controls
+    delayFormat.reset (new SkinDial ("delayFormat"));
+    addAndMakeVisible (delayFormat.get());
+    delayFormat->setRange (0, 2, 1);
+    delayFormat->setSliderStyle (Slider::RotaryVerticalDrag);
+    delayFormat->setTextBoxStyle (Slider::NoTextBox, true, 80, 20);
+    delayFormat->addListener (this);
+    delayFormat->setBounds (540, 146, 56, 56);
+
+    delayFormatLabel.reset (new Label ("delayFormatLabel", TRANS ("Storage")));
+    addAndMakeVisible (delayFormatLabel.get());
+    delayFormatLabel->setFont (Font (FontOptions (12.00f, Font::plain)).withTypefaceStyle ("Regular"));
+    delayFormatLabel->setJustificationType (Justification::centred);
+    delayFormatLabel->setEditable (false, false, false);
+    delayFormatLabel->setColour (Label::textColourId, Colour (0xe4dfddaf));
+    delayFormatLabel->setColour (TextEditor::textColourId, Colours::black);
+    delayFormatLabel->setColour (TextEditor::backgroundColourId, Colour (0x00000000));
+    delayFormatLabel->setBounds (520, 204, 96, 24);
+
+    delayFormatValueLabel.reset (new Label ("delayFormatValueLabel", TRANS ("FLOAT32")));
+    addAndMakeVisible (delayFormatValueLabel.get());
+    delayFormatValueLabel->setFont (Font (FontOptions (10.00f, Font::plain)).withTypefaceStyle ("Regular"));
+    delayFormatValueLabel->setJustificationType (Justification::centred);
+    delayFormatValueLabel->setEditable (false, false, false);
+    delayFormatValueLabel->setColour (Label::textColourId, Colour (0xe4dfddaf));
+    delayFormatValueLabel->setColour (TextEditor::textColourId, Colours::black);
+    delayFormatValueLabel->setColour (TextEditor::backgroundColourId, Colour (0x00000000));
+    delayFormatValueLabel->setBounds (528, 220, 80, 16);
+
+    combTier.reset (new SkinDial ("combTier"));
+    addAndMakeVisible (combTier.get());
+    combTier->setRange (0, 2, 1);
+    combTier->setSliderStyle (Slider::RotaryVerticalDrag);
+    combTier->setTextBoxStyle (Slider::NoTextBox, true, 80, 20);
+    combTier->addListener (this);
+    combTier->setBounds (620, 146, 56, 56);
+
+    combTierLabel.reset (new Label ("combTierLabel", TRANS ("Density")));
+    addAndMakeVisible (combTierLabel.get());
+    combTierLabel->setFont (Font (FontOptions (12.00f, Font::plain)).withTypefaceStyle ("Regular"));
+    combTierLabel->setJustificationType (Justification::centred);
+    combTierLabel->setEditable (false, false, false);
+    combTierLabel->setColour (Label::textColourId, Colour (0xe4dfddaf));
+    combTierLabel->setColour (TextEditor::textColourId, Colours::black);
+    combTierLabel->setColour (TextEditor::backgroundColourId, Colour (0x00000000));
+    combTierLabel->setBounds (620, 204, 56, 24);
+
+    combTierValueLabel.reset (new Label ("combTierValueLabel", TRANS ("STANDARD")));
+    addAndMakeVisible (combTierValueLabel.get());
+    combTierValueLabel->setFont (Font (FontOptions (10.00f, Font::plain)).withTypefaceStyle ("Regular"));
+    combTierValueLabel->setJustificationType (Justification::centred);
+    combTierValueLabel->setEditable (false, false, false);
+    combTierValueLabel->setColour (Label::textColourId, Colour (0xe4dfddaf));
+    combTierValueLabel->setColour (TextEditor::textColourId, Colours::black);
+    combTierValueLabel->setColour (TextEditor::backgroundColourId, Colour (0x00000000));
+    combTierValueLabel->setBounds (616, 220, 64, 16);
+
+    decimated.reset (new ToggleSwitch ("decimated"));
+    addAndMakeVisible (decimated.get());
+    decimated->setButtonText (String());
+    decimated->addListener (this);
+    decimated->setBounds (700, 150, 40, 40);
+
+    decimatedLabel.reset (new Label ("decimatedLabel", TRANS ("Decimate")));
+    addAndMakeVisible (decimatedLabel.get());
+    decimatedLabel->setFont (Font (FontOptions (12.00f, Font::plain)).withTypefaceStyle ("Regular"));
+    decimatedLabel->setJustificationType (Justification::centred);
+    decimatedLabel->setEditable (false, false, false);
+    decimatedLabel->setColour (Label::textColourId, Colour (0xe4dfddaf));
+    decimatedLabel->setColour (TextEditor::textColourId, Colours::black);
+    decimatedLabel->setColour (TextEditor::backgroundColourId, Colour (0x00000000));
+    decimatedLabel->setBounds (680, 194, 80, 24);
+
+    decimatedStateLabel.reset (new Label ("decimatedStateLabel", TRANS ("OFF")));
+    addAndMakeVisible (decimatedStateLabel.get());
+    decimatedStateLabel->setFont (Font (FontOptions (10.00f, Font::plain)).withTypefaceStyle ("Regular"));
+    decimatedStateLabel->setJustificationType (Justification::centred);
+    decimatedStateLabel->setEditable (false, false, false);
+    decimatedStateLabel->setColour (Label::textColourId, Colour (0xe4dfddaf));
+    decimatedStateLabel->setColour (TextEditor::textColourId, Colours::black);
+    decimatedStateLabel->setColour (TextEditor::backgroundColourId, Colour (0x00000000));
+    decimatedStateLabel->setBounds (700, 210, 40, 16);
+
+    engineLoadLabel.reset (new Label ("engineLoadLabel", String()));
+    addAndMakeVisible (engineLoadLabel.get());
+    engineLoadLabel->setFont (Font (FontOptions (10.00f, Font::plain)).withTypefaceStyle ("Regular"));
+    engineLoadLabel->setJustificationType (Justification::centredRight);
+    engineLoadLabel->setEditable (false, false, false);
+    engineLoadLabel->setColour (Label::textColourId, Colour (0xe4dfddaf));
+    engineLoadLabel->setColour (TextEditor::textColourId, Colours::black);
+    engineLoadLabel->setColour (TextEditor::backgroundColourId, Colour (0x00000000));
+    engineLoadLabel->setBounds (460, 20, 248, 16);
+
     randomEnabledStateLabel.reset (new Label ("randomEnabledStateLabel", TRANS ("OFF")));
     addAndMakeVisible (randomEnabledStateLabel.get());
     randomEnabledStateLabel->setFont (Font (FontOptions (10.00f, Font::plain)).withTypefaceStyle ("Regular"));
@@ -423,7 +542,7 @@ PluginView::PluginView() {
     }
     //[/UserPreSize]
 
-    setSize (720, 220);
+    setSize (780, 240);
 
     //[Constructor] You can add your own custom stuff here..
     about.setPluginName ("SYNC_ROBO_VERB");
@@ -487,6 +606,21 @@ PluginView::~PluginView() {
     crossfadeRate = nullptr;
     crossfadeRateLabel = nullptr;
     crossfadeRateValueLabel = nullptr;
+    fadeCurve = nullptr;
+    fadeCurveLabel = nullptr;
+    fadeCurveValueLabel = nullptr;
+
+    // Engine controls
+    delayFormat = nullptr;
+    delayFormatLabel = nullptr;
+    delayFormatValueLabel = nullptr;
+    combTier = nullptr;
+    combTierLabel = nullptr;
+    combTierValueLabel = nullptr;
+    decimated = nullptr;
+    decimatedLabel = nullptr;
+    decimatedStateLabel = nullptr;
+    engineLoadLabel = nullptr;
 
     //[Destructor]. You can add your own custom destruction code here..
     //[/Destructor]
@@ -525,14 +659,12 @@ void PluginView::resized() {
 void PluginView::buttonClicked (Button* buttonThatWasClicked) {
     //[UserbuttonClicked_Pre]
     if (combButtons.contains (buttonThatWasClicked)) {
-        combs.setBit (combButtons.indexOf (buttonThatWasClicked),
-                      buttonThatWasClicked->getToggleState());
-        pluginState.setProperty ("enabledCombs", combs.toString (2), nullptr);
+        setSwitch (combButtons.indexOf (buttonThatWasClicked),
+                   buttonThatWasClicked->getToggleState());
         return;
     } else if (allPassButtons.contains (buttonThatWasClicked)) {
-        allpasses.setBit (allPassButtons.indexOf (buttonThatWasClicked),
-                          buttonThatWasClicked->getToggleState());
-        pluginState.setProperty ("enabledAllPasses", allpasses.toString (2), nullptr);
+        setSwitch (SyncRoboVerb::numCombs + allPassButtons.indexOf (buttonThatWasClicked),
+                   buttonThatWasClicked->getToggleState());
         return;
     }
     //[/UserbuttonClicked_Pre]
@@ -592,6 +724,9 @@ void PluginView::buttonClicked (Button* buttonThatWasClicked) {
         pluginState.setProperty (Tags::randomEnabled, randomEnabled->getToggleState() ? 1.0f : 0.0f, nullptr);
         updateParameterValueDisplays ();
         //[/UserButtonCode_randomEnabled]
+    } else if (buttonThatWasClicked == decimated.get()) {
+        pluginState.setProperty (Tags::decimated, decimated->getToggleState(), nullptr);
+        updateParameterValueDisplays ();
     }
 
     //[UserbuttonClicked_Post]
@@ -637,6 +772,15 @@ void PluginView::sliderValueChanged (Slider* sliderThatWasMoved) {
         pluginState.setProperty (Tags::crossfadeRate, (float)crossfadeRate->getValue(), nullptr);
         updateParameterValueDisplays ();
         //[/UserSliderCode_crossfadeRate]
+    } else if (sliderThatWasMoved == fadeCurve.get()) {
+        pluginState.setProperty (Tags::fadeCurve, (float) fadeCurve->getValue(), nullptr);
+        updateParameterValueDisplays ();
+    } else if (sliderThatWasMoved == delayFormat.get()) {
+        pluginState.setProperty (Tags::delayFormat, (int) delayFormat->getValue(), nullptr);
+        updateParameterValueDisplays ();
+    } else if (sliderThatWasMoved == combTier.get()) {
+        pluginState.setProperty (Tags::combTier, (int) combTier->getValue(), nullptr);
+        updateParameterValueDisplays ();
     }
 
     //[UsersliderValueChanged_Post]
@@ -668,13 +812,8 @@ void PluginView::stabilizeComponents (ValueTree newPluginState) {
     damping->getValueObject().referTo (
         pluginState.getPropertyAsValue ("damping", nullptr));
 
-    combs.parseString (pluginState.getProperty (Tags::enabledCombs).toString(), 2);
-    allpasses.parseString (pluginState.getProperty (Tags::enabledAllPasses).toString(), 2);
-
-    for (int i = 0; i < combButtons.size(); ++i)
-        combButtons.getUnchecked (i)->setToggleState (combs[i], dontSendNotification);
-    for (int i = 0; i < allPassButtons.size(); ++i)
-        allPassButtons.getUnchecked (i)->setToggleState (allpasses[i], dontSendNotification);
+    switches = (uint16) (int) pluginState.getProperty (Tags::switchMask);
+    updateSwitchButtons();
 
     // Randomization controls
     randomEnabled->setToggleState ((float)pluginState.getProperty (Tags::randomEnabled) > 0.5f, dontSendNotification);
@@ -697,6 +836,22 @@ void PluginView::stabilizeComponents (ValueTree newPluginState) {
     crossfadeRate->getValueObject().referTo (
         pluginState.getPropertyAsValue (Tags::crossfadeRate, nullptr));
 
+    fadeCurve->setValue (pluginState.getProperty (Tags::fadeCurve), dontSendNotification);
+    fadeCurve->getValueObject().referTo (
+        pluginState.getPropertyAsValue (Tags::fadeCurve, nullptr));
+
+    delayFormat->setValue (pluginState.getProperty (Tags::delayFormat), dontSendNotification);
+    delayFormat->getValueObject().referTo (
+        pluginState.getPropertyAsValue (Tags::delayFormat, nullptr));
+
+    combTier->setValue (pluginState.getProperty (Tags::combTier), dontSendNotification);
+    combTier->getValueObject().referTo (
+        pluginState.getPropertyAsValue (Tags::combTier, nullptr));
+
+    decimated->setToggleState ((bool) pluginState.getProperty (Tags::decimated), dontSendNotification);
+    decimated->getToggleStateValue().referTo (
+        pluginState.getPropertyAsValue (Tags::decimated, nullptr));
+
     // Update parameter value displays
     updateParameterValueDisplays ();
 }
@@ -706,14 +861,9 @@ void PluginView::valueTreePropertyChanged (ValueTree& tree, const Identifier& pr
         return;
 
     const var& value (tree.getProperty (property));
-    if (property == Tags::enabledCombs) {
-        combs.parseString (value.toString(), 2);
-        for (int i = 0; i < combButtons.size(); ++i)
-            combButtons.getUnchecked (i)->setToggleState (combs[i], dontSendNotification);
-    } else if (property == Tags::enabledAllPasses) {
-        allpasses.parseString (value.toString(), 2);
-        for (int i = 0; i < allPassButtons.size(); ++i)
-            allPassButtons.getUnchecked (i)->setToggleState (allpasses[i], dontSendNotification);
+    if (property == Tags::switchMask) {
+        switches = (uint16) (int) value;
+        updateSwitchButtons();
     } else if (property == Tags::randomEnabled) {
         randomEnabled->setToggleState ((float)value > 0.5f, dontSendNotification);
     } else if (property == Tags::randomRate) {
@@ -724,9 +874,32 @@ void PluginView::valueTreePropertyChanged (ValueTree& tree, const Identifier& pr
         randomFilters->setValue (value, dontSendNotification);
     } else if (property == Tags::crossfadeRate) {
         crossfadeRate->setValue (value, dontSendNotification);
+    } else if (property == Tags::fadeCurve) {
+        fadeCurve->setValue (value, dontSendNotification);
+    } else if (property == Tags::delayFormat) {
+        delayFormat->setValue (value, dontSendNotification);
+    } else if (property == Tags::combTier) {
+        combTier->setValue (value, dontSendNotification);
+    } else if (property == Tags::decimated) {
+        decimated->setToggleState ((bool) value, dontSendNotification);
     }
 }
 
+void PluginView::setSwitch (const int index, const bool toggled) {
+    const auto bit = (uint16) (1u << index);
+    switches = toggled ? (uint16) (switches | bit) : (uint16) (switches & ~bit);
+    pluginState.setProperty (Tags::switchMask, (int) switches, nullptr);
+}
+
+void PluginView::updateSwitchButtons() {
+    for (int i = 0; i < combButtons.size(); ++i)
+        combButtons.getUnchecked (i)->setToggleState (
+            (switches & SyncRoboVerb::combBit (i)) != 0, dontSendNotification);
+    for (int i = 0; i < allPassButtons.size(); ++i)
+        allPassButtons.getUnchecked (i)->setToggleState (
+            (switches & SyncRoboVerb::allPassBit (i)) != 0, dontSendNotification);
+}
+
 void PluginView::setSphereValue (const float val) {
     sphere->setValue (val);
     sphere->repaint();
@@ -778,12 +951,27 @@ void PluginView::updateParameterValueDisplays () {
         default: crossfadeText = "1/32"; break;
     }
     crossfadeRateValueLabel->setText (crossfadeText, dontSendNotification);
+    fadeCurveValueLabel->setText ((int) fadeCurve->getValue() == (int) FadeCurve::linear ? "LINEAR" : "EQUAL POWER",
+                                  dontSendNotification);
+
+    // Update storage display
+    const auto format = (DelayFormat) jlimit (0, (int) DelayFormat::int16, (int) delayFormat->getValue());
+    delayFormatValueLabel->setText (String (getDelayFormatName (format)).toUpperCase(), dontSendNotification);
+    const auto tier = (CombTier) jlimit (0, (int) CombTier::numTiers - 1, (int) combTier->getValue());
+    combTierValueLabel->setText (String (getCombTierName (tier)).toUpperCase(), dontSendNotification);
+    decimatedStateLabel->setText (decimated->getToggleState() ? "ON" : "OFF", dontSendNotification);
 
     // Update enabled state display
     String stateText = randomEnabled->getToggleState() ? "ON" : "OFF";
     randomEnabledStateLabel->setText (stateText, dontSendNotification);
 }
 
+void PluginView::setEngineLoad (const int delayMemorySize, const double processingLoad) {
+    engineLoadLabel->setText (String (delayMemorySize / 1024) + " KiB delay lines, "
+                                  + String (roundToInt (processingLoad * 100.0)) + "% CPU",
+                              dontSendNotification);
+}
+
 void PluginView::mouseDown (const MouseEvent& ev) {
     if (about.isVisible())
         about.setVisible (false);
@@ -124,6 +124,7 @@ public:
     void stabilizeComponents (ValueTree pluginState);
     void setSphereValue (const float val);
     void updateParameterValueDisplays ();
+    void setEngineLoad (int delayMemorySize, double processingLoad);
     void mouseDown (const MouseEvent& ev) override;
     //[/UserMethods]
 
@@ -136,9 +137,12 @@ private:
     //[UserVariables]   -- You can add your own custom variables in this section.
     AboutBox about;
     ValueTree pluginState;
-    BigInteger combs, allpasses;
+    uint16 switches { 0 };
     Array<Button*> combButtons, allPassButtons;
 
+    void setSwitch (const int index, const bool toggled);
+    void updateSwitchButtons();
+
     friend class ModuleUI;
     friend class ValueTree::Listener;
     virtual void valueTreePropertyChanged (ValueTree&, const Identifier&) override;
@@ -197,6 +201,21 @@ private:
     std::unique_ptr<SkinDial> crossfadeRate;
     std::unique_ptr<Label> crossfadeRateLabel;
     std::unique_ptr<Label> crossfadeRateValueLabel;
+    std::unique_ptr<SkinDial> fadeCurve;
+    std::unique_ptr<Label> fadeCurveLabel;
+    std::unique_ptr<Label> fadeCurveValueLabel;
+
+    // Engine controls
+    std::unique_ptr<SkinDial> delayFormat;
+    std::unique_ptr<Label> delayFormatLabel;
+    std::unique_ptr<Label> delayFormatValueLabel;
+    std::unique_ptr<SkinDial> combTier;
+    std::unique_ptr<Label> combTierLabel;
+    std::unique_ptr<Label> combTierValueLabel;
+    std::unique_ptr<ToggleSwitch> decimated;
+    std::unique_ptr<Label> decimatedLabel;
+    std::unique_ptr<Label> decimatedStateLabel;
+    std::unique_ptr<Label> engineLoadLabel;
 
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PluginView)
@@ -7,277 +7,71 @@
 namespace syncroboverb {
 
 Processor::Processor()
-    : numParameters (SyncRoboVerb::numParameters + 12),
-      numKnobs (SyncRoboVerb::numParameters),
-      state ("syncroboverb") {
+    : state ("syncroboverb") {
+    const SyncRoboVerb::Parameters defaults;
+    const auto percent = AudioParameterFloatAttributes().withStringFromValueFunction (
+        [] (float value, int) { return String ((int) (value * 100.0f)) + "%"; });
+
+    // note: do not change the order, hosts find automation saved against the
+    // old numbered parameters by it
+    addParameter (roomSize = new AudioParameterFloat ({ Tags::roomSize.toString(), 1 }, "Room size", 0.0f, 1.0f, defaults.roomSize));
+    addParameter (damping = new AudioParameterFloat ({ Tags::damping.toString(), 1 }, "Damping", 0.0f, 1.0f, defaults.damping));
+    addParameter (wetLevel = new AudioParameterFloat ({ Tags::wetLevel.toString(), 1 }, "Wet level", 0.0f, 1.0f, defaults.wetLevel));
+    addParameter (dryLevel = new AudioParameterFloat ({ Tags::dryLevel.toString(), 1 }, "Dry level", 0.0f, 1.0f, defaults.dryLevel));
+    addParameter (width = new AudioParameterFloat ({ Tags::width.toString(), 1 }, "Width", 0.0f, 1.0f, defaults.width));
+    addParameter (freezeMode = new AudioParameterBool ({ Tags::freezeMode.toString(), 1 }, "Freeze mode", defaults.freezeMode >= 0.5f));
+    addParameter (randomEnabled = new AudioParameterBool ({ Tags::randomEnabled.toString(), 1 }, "Random enabled", defaults.randomEnabled >= 0.5f));
+    addParameter (randomRate = new AudioParameterChoice ({ Tags::randomRate.toString(), 1 }, "Random rate",
+                                                         { "1/16", "1/8", "1/4", "1/2", "1", "2 bars", "4 bars", "8 bars" },
+                                                         (int) defaults.randomRate));
+    addParameter (randomAmount = new AudioParameterFloat ({ Tags::randomAmount.toString(), 1 }, "Random amount",
+                                                          NormalisableRange<float> (0.0f, 1.0f), defaults.randomAmount, percent));
+    addParameter (randomFilters = new AudioParameterChoice ({ Tags::randomFilters.toString(), 1 }, "Random filters",
+                                                            { "Comb", "AllPass", "Both" }, (int) defaults.randomFilters));
+    addParameter (crossfadeRate = new AudioParameterChoice ({ Tags::crossfadeRate.toString(), 1 }, "Crossfade rate",
+                                                            { "Instant", "1/64", "1/32", "1/16", "1/8", "1/4" },
+                                                            (int) defaults.crossfadeRate));
+
+    hostSwitches = publishedSwitches = verb.getSwitchMask();
+    for (int i = 0; i < numSwitches; ++i) {
+        const bool isComb = i < SyncRoboVerb::numCombs;
+        const int number = (isComb ? i : i - SyncRoboVerb::numCombs) + 1;
+        addParameter (switchParams[(size_t) i] = new AudioParameterBool (
+                          { (isComb ? "comb-" : "allpass-") + String (number), 1 },
+                          (isComb ? "Comb Filter " : "AllPass Filter ") + String (number),
+                          (hostSwitches & (1u << i)) != 0));
+    }
+
+    // added since, so after the switches
+    const auto notAutomatable = AudioParameterChoiceAttributes().withAutomatable (false);
+    addParameter (delayFormat = new AudioParameterChoice ({ Tags::delayFormat.toString(), 1 }, "Delay storage",
+                                                          { "float32", "bfloat16", "int16" },
+                                                          (int) verb.getDelayFormat(), notAutomatable));
+    delayFormat->addListener (this);
+    addParameter (decimated = new AudioParameterBool ({ Tags::decimated.toString(), 1 }, "Decimated wet path",
+                                                      verb.isDecimated(),
+                                                      AudioParameterBoolAttributes().withAutomatable (false)));
+    decimated->addListener (this);
+    addParameter (fadeCurve = new AudioParameterChoice ({ Tags::fadeCurve.toString(), 1 }, "Crossfade curve",
+                                                        { "Linear", "Equal power" },
+                                                        (int) verb.getCrossfadeManager().getFadeCurve()));
+    addParameter (combTier = new AudioParameterChoice ({ Tags::combTier.toString(), 1 }, "Comb density",
+                                                       { "Standard", "Dense", "Densest" },
+                                                       (int) verb.getCombTier(), notAutomatable));
+    combTier->addListener (this);
+
+    networkSettings = verb.getNetworkSettings();
+    delayMemorySize = (int) verb.getDelayMemorySize();
     updateState();
     state.addListener (this);
 }
 
 Processor::~Processor() {
     state.removeListener (this);
+    freeNetworks();
 }
 
 const String Processor::getName() const { return "SyncRoboVerb"; }
-int Processor::getNumParameters() {
-    // SyncRoboVerb::numParameters includes all reverb parameters + randomization parameters
-    // +12 is for the number of switches (8 combs + 4 allpasses)
-    return numParameters;
-}
-
-float Processor::getParameter (int index) {
-    if (index >= numKnobs && index < numParameters) {
-        const int filterIndex = index - numKnobs;
-
-        if (filterIndex < 8) {
-            return verb.toggledCombFloat (filterIndex);
-        } else {
-            return verb.toggledAllPassFloat (filterIndex - 8);
-        }
-    } else {
-        const SyncRoboVerb::Parameters& p (verb.getParameters());
-        switch (index) {
-            case SyncRoboVerb::RoomSize:
-                return p.roomSize;
-                break;
-            case SyncRoboVerb::Damping:
-                return p.damping;
-                break;
-            case SyncRoboVerb::WetLevel:
-                return p.wetLevel;
-                break;
-            case SyncRoboVerb::DryLevel:
-                return p.dryLevel;
-                break;
-            case SyncRoboVerb::Width:
-                return p.width;
-                break;
-            case SyncRoboVerb::FreezeMode:
-                return p.freezeMode;
-                break;
-            case SyncRoboVerb::RandomEnabled:
-                return p.randomEnabled;
-                break;
-            case SyncRoboVerb::RandomRate:
-                return p.randomRate;
-                break;
-            case SyncRoboVerb::RandomAmount:
-                return p.randomAmount;
-                break;
-            case SyncRoboVerb::RandomFilters:
-                return p.randomFilters;
-                break;
-            case SyncRoboVerb::CrossfadeRate:
-                return p.crossfadeRate;
-                break;
-        }
-    }
-
-    return 0.0f;
-}
-
-void Processor::setParameter (int index, float newValue) {
-    if (index >= numKnobs && index < numParameters) {
-        ScopedLock lock (getCallbackLock());
-        const bool isSet = (newValue < 0.5) ? false : true;
-        const int filterIndex = index - numKnobs;
-        
-        // Use crossfading for smooth transitions
-        bool combStates[8];
-        bool allPassStates[4];
-        
-        // Get current states
-        for (int i = 0; i < 8; ++i) {
-            combStates[i] = (verb.toggledCombFloat(i) >= 0.5f);
-        }
-        for (int i = 0; i < 4; ++i) {
-            allPassStates[i] = (verb.toggledAllPassFloat(i) >= 0.5f);
-        }
-        
-        // Update the specific switch
-        if (filterIndex < 8) {
-            combStates[filterIndex] = isSet;
-        } else {
-            allPassStates[filterIndex - 8] = isSet;
-        }
-        
-        // Apply changes with crossfading
-        verb.updateAllFilters(combStates, allPassStates);
-    } else {
-        switch (index) {
-            case SyncRoboVerb::RoomSize:
-                params.roomSize = newValue;
-                break;
-            case SyncRoboVerb::Damping:
-                params.damping = newValue;
-                break;
-            case SyncRoboVerb::WetLevel:
-                params.wetLevel = newValue;
-                break;
-            case SyncRoboVerb::DryLevel:
-                params.dryLevel = newValue;
-                break;
-            case SyncRoboVerb::Width:
-                params.width = newValue;
-                break;
-            case SyncRoboVerb::FreezeMode:
-                params.freezeMode = newValue;
-                break;
-            case SyncRoboVerb::RandomEnabled:
-                params.randomEnabled = newValue;
-                verb.getRandomizer().setEnabled(newValue >= 0.5f);
-                break;
-            case SyncRoboVerb::RandomRate:
-                params.randomRate = newValue;
-                verb.getRandomizer().setRate(static_cast<TempoSyncedRandomizer::RandomRate>(
-                    juce::jlimit(0, TempoSyncedRandomizer::numRates - 1, (int)newValue)));
-                break;
-            case SyncRoboVerb::RandomAmount:
-                params.randomAmount = newValue;
-                verb.getRandomizer().setAmount(newValue);
-                break;
-            case SyncRoboVerb::RandomFilters:
-                params.randomFilters = newValue;
-                verb.getRandomizer().setFilterType(static_cast<TempoSyncedRandomizer::FilterType>(
-                    juce::jlimit(0, TempoSyncedRandomizer::numFilterTypes - 1, (int)newValue)));
-                break;
-            case SyncRoboVerb::CrossfadeRate:
-                params.crossfadeRate = newValue;
-                verb.getCrossfadeManager().setCrossfadeTiming(static_cast<TempoSyncedCrossfadeManager::CrossfadeTiming>(
-                    juce::jlimit(0, TempoSyncedCrossfadeManager::numTimings - 1, (int)newValue)));
-                break;
-        }
-
-        ScopedLock lock (getCallbackLock());
-        if (params != verb.getParameters())
-            verb.setParameters (params);
-    }
-}
-
-String Processor::getParameterName (int index, int) {
-    if (index >= numKnobs && index < numParameters) {
-        const int filterIndex = index - numKnobs;
-        if (filterIndex < 8) {
-            return String ("Comb Filter ") + String (filterIndex + 1);
-        } else {
-            return String ("AllPass Filter ") + String (filterIndex - 8 + 1);
-        }
-    }
-
-    switch (index) {
-        case SyncRoboVerb::RoomSize:
-            return "Room size";
-            break;
-        case SyncRoboVerb::Damping:
-            return "Damping";
-            break;
-        case SyncRoboVerb::WetLevel:
-            return "Wet level";
-            break;
-        case SyncRoboVerb::DryLevel:
-            return "Dry level";
-            break;
-        case SyncRoboVerb::Width:
-            return "Width";
-            break;
-        case SyncRoboVerb::FreezeMode:
-            return "Freeze mode";
-            break;
-        case SyncRoboVerb::RandomEnabled:
-            return "Random enabled";
-            break;
-        case SyncRoboVerb::RandomRate:
-            return "Random rate";
-            break;
-        case SyncRoboVerb::RandomAmount:
-            return "Random amount";
-            break;
-        case SyncRoboVerb::RandomFilters:
-            return "Random filters";
-            break;
-        case SyncRoboVerb::CrossfadeRate:
-            return "Crossfade rate";
-            break;
-    }
-
-    return String();
-}
-
-String Processor::getParameterText (int index, int maxLen) {
-    if (index >= numKnobs && index < numParameters) {
-        getParameterName (index - numKnobs, maxLen);
-    }
-
-    switch (index) {
-        case SyncRoboVerb::RoomSize:
-            return String(params.roomSize, 2);
-            break;
-        case SyncRoboVerb::Damping:
-            return String(params.damping, 2);
-            break;
-        case SyncRoboVerb::WetLevel:
-            return String(params.wetLevel, 2);
-            break;
-        case SyncRoboVerb::DryLevel:
-            return String(params.dryLevel, 2);
-            break;
-        case SyncRoboVerb::Width:
-            return String(params.width, 2);
-            break;
-        case SyncRoboVerb::FreezeMode:
-            return params.freezeMode >= 0.5f ? "On" : "Off";
-            break;
-        case SyncRoboVerb::RandomEnabled:
-            return params.randomEnabled >= 0.5f ? "On" : "Off";
-            break;
-        case SyncRoboVerb::RandomRate:
-        {
-            int rateValue = (int)params.randomRate;
-            switch (rateValue) {
-                case 0: return "1/16";
-                case 1: return "1/8";
-                case 2: return "1/4";
-                case 3: return "1/2";
-                case 4: return "1";
-                case 5: return "2 bars";
-                case 6: return "4 bars";
-                case 7: return "8 bars";
-                default: return "1/4";
-            }
-            break;
-        }
-        case SyncRoboVerb::RandomAmount:
-            return String((int)(params.randomAmount * 100.0f)) + "%";
-            break;
-        case SyncRoboVerb::RandomFilters:
-        {
-            int filtersValue = (int)params.randomFilters;
-            switch (filtersValue) {
-                case 0: return "Comb";
-                case 1: return "AllPass";
-                case 2: return "Both";
-                default: return "Both";
-            }
-            break;
-        }
-        case SyncRoboVerb::CrossfadeRate:
-        {
-            int crossfadeValue = (int)params.crossfadeRate;
-            switch (crossfadeValue) {
-                case 0: return "Instant";
-                case 1: return "1/64";
-                case 2: return "1/32";
-                case 3: return "1/16";
-                case 4: return "1/8";
-                case 5: return "1/4";
-                default: return "1/32";
-            }
-            break;
-        }
-    }
-
-    return String();
-}
 
 const String Processor::getInputChannelName (int channelIndex) const {
     return String (channelIndex + 1);
@@ -304,15 +98,45 @@ void Processor::changeProgramName (int index, const String& newName) {
     juce::ignoreUnused (index, newName);
 }
 
-void Processor::prepareToPlay (double sampleRate, int /*samplesPerBlock*/) {
+void Processor::prepareToPlay (double sampleRate, int samplesPerBlock) {
+    verb.setKernels (kernels::getPreferredIsa());
     verb.reset();
-    verb.setSampleRate (sampleRate);
+
+    // the audio thread is stopped here, so the settings go in directly
+    freeNetworks();
+    networkSettings = readNetworkSettings();
+    verb.setNetwork (networkSettings, sampleRate);
+    delayMemorySize = (int) verb.getDelayMemorySize();
+    networkLatency = verb.getLatencySamples();
+    setLatencySamples (networkLatency.get());
+    loadMeasurer.reset (sampleRate, samplesPerBlock);
+    stallDetector.setEnabled (DenormalStallDetector::isRequested());
+    stallDetector.reset();
+    numSamplesProcessed = 0;
+    lastPpqPosition = nextPpqPosition = -1.0;
+
+    // logged rather than DBG'd, so release builds report it too; the editor
+    // shows the memory and the load as they change
+    Logger::writeToLog ("SyncRoboVerb: " + String (delayMemorySize.get() / 1024) + " KiB of "
+                        + getDelayFormatName (verb.getDelayFormat()) + " delay lines, "
+                        + getCombTierName (verb.getCombTier()) + " combs, "
+                        + kernels::getIsaName (verb.getKernels()) + " kernels, wet path at "
+                        + String (verb.getInternalSampleRate()) + " Hz");
 }
 
-void Processor::releaseResources() {}
+void Processor::releaseResources() {
+    // logged rather than DBG'd, so the check reports in release builds too
+    if (stallDetector.isEnabled() && stallDetector.getNumTailBlocks() > 0)
+        Logger::writeToLog ("SyncRoboVerb: " + String (stallDetector.getNumStalls()) + " of "
+                            + String (stallDetector.getNumTailBlocks()) + " tail blocks stalled, worst "
+                            + String (stallDetector.getWorstRatio(), 2) + "x");
+}
+
+template <typename SampleType>
+void Processor::process (AudioBuffer<SampleType>& buffer) {
+    // the kernels leave denormals to the hardware
+    ScopedNoDenormals noDenormals;
 
-void Processor::processBlock (AudioBuffer<double>&, MidiBuffer&) { jassertfalse; }
-void Processor::processBlock (AudioBuffer<float>& buffer, MidiBuffer&) {
     // In case we have more outputs than inputs, this code clears any output
     // channels that didn't contain input data, (because these aren't
     // guaranteed to be empty - they may contain garbage).
@@ -322,44 +146,208 @@ void Processor::processBlock (AudioBuffer<float>& buffer, MidiBuffer&) {
     for (int i = getTotalNumInputChannels(); i < getTotalNumOutputChannels(); ++i)
         buffer.clear (i, 0, buffer.getNumSamples());
 
+    const int numSamples = buffer.getNumSamples();
+    const AudioProcessLoadMeasurer::ScopedTimer loadTimer (loadMeasurer, numSamples);
+    installPendingNetwork();
+
     // Handle tempo-synced randomization and crossfading
+    bool hasTempo = false;
+    double bpm = 150.0, ppqPosition = 0.0, ppqPerSample = 0.0;
     if (auto* playHead = getPlayHead()) {
         if (auto positionInfo = playHead->getPosition()) {
-            double bpm = positionInfo->getBpm().orFallback(150.0);
-            double ppqPosition = positionInfo->getPpqPosition().orFallback(0.0);
-            
-            // Update crossfade manager tempo
-            verb.getCrossfadeManager().updateTempo(bpm, getSampleRate());
-            
-            // Process randomization
-            verb.getRandomizer().processTempo(bpm, ppqPosition, verb);
-            
-            // Check if randomization has changed switches and update UI
-            if (verb.getRandomizer().checkAndClearSwitchesChanged()) {
-                // Capture the current switch states immediately
-                BigInteger newCombs, newAllPasses;
-                verb.getRandomizer().getUpdatedSwitchStates(verb, newCombs, newAllPasses);
-                
-                // Store for later UI update (safer than async)
-                pendingCombsUpdate = newCombs.toString(2);
-                pendingAllPassesUpdate = newAllPasses.toString(2);
-                hasPendingUIUpdate = true;
+            hasTempo = true;
+            bpm = positionInfo->getBpm().orFallback(150.0);
+            ppqPosition = positionInfo->getPpqPosition().orFallback(0.0);
+
+            // the randomizer finds beat boundaries inside the block from this
+            if (positionInfo->getIsPlaying() && positionInfo->getPpqPosition().hasValue()) {
+                ppqPerSample = bpm / (60.0 * getSampleRate());
+
+                // a wrapper splitting the host's block at parameter changes may
+                // give every piece the position of the whole block
+                const double reported = ppqPosition;
+                if (exactlyEqual (reported, lastPpqPosition))
+                    ppqPosition = nextPpqPosition;
+                lastPpqPosition = reported;
+                nextPpqPosition = ppqPosition + numSamples * ppqPerSample;
+            } else {
+                // so playing again from where it stopped isn't taken for a split
+                lastPpqPosition = nextPpqPosition = -1.0;
             }
+
+            // Update crossfade manager tempo
+            verb.getCrossfadeManager().updateTempo(bpm, verb.getInternalSampleRate());
         }
     }
 
-    if (buffer.getNumChannels() >= 2) {
-        verb.processStereo (buffer.getWritePointer (0),
-                            buffer.getWritePointer (1),
-                            buffer.getNumSamples());
-        rmsValue.set ((buffer.getRMSLevel (0, 0, buffer.getNumSamples()) + buffer.getRMSLevel (1, 0, buffer.getNumSamples())) * 0.5f);
-    } else if (buffer.getNumChannels() == 1) {
-        verb.processMono (buffer.getWritePointer (0),
-                          buffer.getNumSamples());
-        rmsValue.set (buffer.getRMSLevel (0, 0, buffer.getNumSamples()));
+    const bool inputSilent = stallDetector.isEnabled()
+                             && buffer.getMagnitude (0, numSamples) < (SampleType) 1.0e-6;
+    stallDetector.blockStarted();
+
+    // The block is split wherever the randomizer has switches to flip, so
+    // they flip on the beat however large the host's blocks are. Parameters
+    // are read again for every piece. Only the CLAP wrapper splits blocks at
+    // parameter events; JUCE's VST3 and AU wrappers set the last value of a
+    // block before it starts, so there automation moves once per block and
+    // the smoothers ramp between those steps.
+    for (int pos = 0; pos < numSamples;) {
+        int num = numSamples - pos;
+        applyParameters();
+
+        if (hasTempo)
+            num = verb.getRandomizer().processTempo (bpm, ppqPosition + pos * ppqPerSample, ppqPerSample, num, verb);
+
+        // Let the UI know if the randomizer or the host has changed switches
+        if (verb.getSwitchMask() != publishedSwitches) {
+            publishedSwitches = verb.getSwitchMask();
+            switchEvents.publish (publishedSwitches, numSamplesProcessed + pos);
+        }
+
+        if (buffer.getNumChannels() >= 2)
+            verb.processStereo (buffer.getWritePointer (0, pos), buffer.getWritePointer (1, pos), num);
+        else if (buffer.getNumChannels() == 1)
+            verb.processMono (buffer.getWritePointer (0, pos), num);
+
+        pos += num;
     }
+
+    if (buffer.getNumChannels() >= 2)
+        rmsValue.set ((float) (buffer.getRMSLevel (0, 0, numSamples) + buffer.getRMSLevel (1, 0, numSamples)) * 0.5f);
+    else if (buffer.getNumChannels() == 1)
+        rmsValue.set ((float) buffer.getRMSLevel (0, 0, numSamples));
+
+    stallDetector.blockFinished (numSamples, inputSilent, verb.isIdle());
+    numSamplesProcessed += numSamples;
+}
+
+SyncRoboVerb::Parameters Processor::readParameters() const noexcept {
+    SyncRoboVerb::Parameters p;
+    p.roomSize = roomSize->get();
+    p.damping = damping->get();
+    p.wetLevel = wetLevel->get();
+    p.dryLevel = dryLevel->get();
+    p.width = width->get();
+    p.freezeMode = freezeMode->get() ? 1.0f : 0.0f;
+    p.randomEnabled = randomEnabled->get() ? 1.0f : 0.0f;
+    p.randomRate = (float) randomRate->getIndex();
+    p.randomAmount = randomAmount->get();
+    p.randomFilters = (float) randomFilters->getIndex();
+    p.crossfadeRate = (float) crossfadeRate->getIndex();
+    return p;
+}
+
+void Processor::applyParameters() {
+    SyncRoboVerb::Parameters newParams (readParameters());
+    if (newParams != verb.getParameters()) {
+        const SyncRoboVerb::Parameters& current (verb.getParameters());
+        auto& randomizer (verb.getRandomizer());
+
+        // the randomizer restarts its timing on these, so only pass on the ones that moved
+        if (! exactlyEqual (newParams.randomEnabled, current.randomEnabled))
+            randomizer.setEnabled (newParams.randomEnabled >= 0.5f);
+        if (! exactlyEqual (newParams.randomRate, current.randomRate))
+            randomizer.setRate (static_cast<TempoSyncedRandomizer::RandomRate> (
+                jlimit (0, TempoSyncedRandomizer::numRates - 1, (int) newParams.randomRate)));
+        if (! exactlyEqual (newParams.randomAmount, current.randomAmount))
+            randomizer.setAmount (newParams.randomAmount);
+        if (! exactlyEqual (newParams.randomFilters, current.randomFilters))
+            randomizer.setFilterType (static_cast<TempoSyncedRandomizer::FilterType> (
+                jlimit (0, TempoSyncedRandomizer::numFilterTypes - 1, (int) newParams.randomFilters)));
+        verb.getCrossfadeManager().setCrossfadeTiming (static_cast<TempoSyncedCrossfadeManager::CrossfadeTiming> (
+            jlimit (0, TempoSyncedCrossfadeManager::numTimings - 1, (int) newParams.crossfadeRate)));
+
+        verb.setParameters (newParams);
+    }
+
+    // The randomizer's flips aren't written back to the switch parameters,
+    // so only the switches the host has moved since last time are applied.
+    // The editor's switches go in as they are, since a click on one the
+    // randomizer has flipped needn't move its parameter at all; the
+    // parameters were set along with them, so are taken as seen.
+    const int fromUI = uiSwitches.exchange (-1);
+    uint16 switches = 0;
+    for (int i = 0; i < numSwitches; ++i)
+        if (switchParams[(size_t) i]->get())
+            switches |= (uint16) (1u << i);
+
+    if (fromUI >= 0) {
+        verb.setSwitchMask ((uint16) fromUI);
+        hostSwitches = switches;
+    } else if (const auto moved = (uint16) (switches ^ hostSwitches)) {
+        verb.setSwitchMask ((uint16) ((verb.getSwitchMask() & ~moved) | (switches & moved)));
+        hostSwitches = switches;
+    }
+
+    const auto curve = (FadeCurve) fadeCurve->getIndex();
+    if (curve != verb.getCrossfadeManager().getFadeCurve())
+        verb.getCrossfadeManager().setFadeCurve (curve);
+}
+
+SyncRoboVerb::NetworkSettings Processor::readNetworkSettings() const noexcept {
+    SyncRoboVerb::NetworkSettings settings;
+    settings.delayFormat = (DelayFormat) delayFormat->getIndex();
+    settings.decimated = decimated->get();
+    settings.combTier = (CombTier) combTier->getIndex();
+    return settings;
+}
+
+void Processor::handleAsyncUpdate() {
+    // the parameters may be set on any thread, the network is only ever
+    // requested from this one
+    const auto settings = readNetworkSettings();
+    if (settings != networkSettings) {
+        networkSettings = settings;
+        requestNetwork();
+    }
+
+    // the audio thread asks for this once it has swapped a network in, so
+    // the host only compensates for latency the plugin really has
+    if (getLatencySamples() != networkLatency.get())
+        setLatencySamples (networkLatency.get());
 }
 
+void Processor::requestNetwork() {
+    // the audio thread hands back one network at a time
+    delete retiredNetwork.exchange (nullptr);
+
+    // prepareToPlay() picks the settings up if there's no rate yet
+    if (getSampleRate() <= 0.0)
+        return;
+
+    auto network = std::make_unique<SyncRoboVerb::PreparedNetwork>();
+    network->prepare (networkSettings, getSampleRate());
+    delayMemorySize = (int) network->getDelayMemorySize();
+    delete pendingNetwork.exchange (network.release());
+}
+
+void Processor::installPendingNetwork() noexcept {
+    // wait until the last one replaced has been freed, so there's somewhere
+    // to put this one's
+    if (retiredNetwork.get() != nullptr)
+        return;
+
+    if (auto* network = pendingNetwork.exchange (nullptr)) {
+        // one prepared for a rate that has since changed is dropped;
+        // prepareToPlay() has installed the current settings
+        if (exactlyEqual (network->getSampleRate(), getSampleRate())) {
+            verb.swapNetwork (*network);
+            networkLatency = verb.getLatencySamples();
+            triggerAsyncUpdate();
+        }
+        retiredNetwork = network;
+    }
+}
+
+void Processor::freeNetworks() {
+    delete pendingNetwork.exchange (nullptr);
+    delete retiredNetwork.exchange (nullptr);
+}
+
+bool Processor::supportsDoublePrecisionProcessing() const { return true; }
+
+void Processor::processBlock (AudioBuffer<float>& buffer, MidiBuffer&) { process (buffer); }
+void Processor::processBlock (AudioBuffer<double>& buffer, MidiBuffer&) { process (buffer); }
+
 bool Processor::hasEditor() const {
     return true;
 }
@@ -378,82 +366,120 @@ void Processor::getStateInformation (MemoryBlock& destData) {
 void Processor::setStateInformation (const void* data, int sizeInBytes) {
     MemoryInputStream stream (data, (size_t) sizeInBytes, false);
     ValueTree nextState = ValueTree::readFromStream (stream);
-    if (nextState.isValid())
-        state.copyPropertiesFrom (nextState, nullptr);
+    if (! nextState.isValid())
+        return;
+
+    // older sessions kept the switches as two binary strings
+    if (! nextState.hasProperty (Tags::switchMask) && nextState.hasProperty (Tags::enabledCombs)) {
+        BigInteger combs, allpasses;
+        combs.parseString (nextState.getProperty (Tags::enabledCombs).toString(), 2);
+        allpasses.parseString (nextState.getProperty (Tags::enabledAllPasses).toString(), 2);
+        const int switches = combs.getBitRangeAsInt (0, SyncRoboVerb::numCombs)
+                             | (allpasses.getBitRangeAsInt (0, SyncRoboVerb::numAllPasses) << SyncRoboVerb::numCombs);
+        nextState.setProperty (Tags::switchMask, switches, nullptr);
+    }
+
+    // sessions from before the choice of curve faded the switches linearly
+    if (! nextState.hasProperty (Tags::fadeCurve))
+        nextState.setProperty (Tags::fadeCurve, (float) FadeCurve::linear, nullptr);
+
+    nextState.removeProperty (Tags::enabledCombs, nullptr);
+    nextState.removeProperty (Tags::enabledAllPasses, nullptr);
+
+    state.copyPropertiesFrom (nextState, nullptr);
 }
 
 void Processor::updateState() {
     state.removeListener (this);
-    BigInteger combs, allpasses;
-    {
-        combs.setRange (0, 8, false);
-        allpasses.setRange (0, 4, false);
-
-        ScopedLock sl (getCallbackLock());
-        params = verb.getParameters();
-        verb.getEnablement (combs, allpasses);
+    copyParametersToState();
+
+    // the engine's switches as last published; the first call has none yet
+    SwitchEventChannel::Event event;
+    if (switchEvents.readSince (lastSwitchEvent, event)) {
+        lastSwitchEvent = event.sequence;
+        state.setProperty (Tags::switchMask, (int) event.mask, nullptr);
+    } else if (! state.hasProperty (Tags::switchMask)) {
+        state.setProperty (Tags::switchMask, (int) publishedSwitches, nullptr);
     }
 
-    state.setProperty (Tags::roomSize, params.roomSize, nullptr);
-    state.setProperty (Tags::damping, params.damping, nullptr);
-    state.setProperty (Tags::wetLevel, params.wetLevel, nullptr);
-    state.setProperty (Tags::dryLevel, params.dryLevel, nullptr);
-    state.setProperty (Tags::width, params.width, nullptr);
-    state.setProperty (Tags::freezeMode, params.freezeMode, nullptr);
-    state.setProperty (Tags::randomEnabled, params.randomEnabled, nullptr);
-    state.setProperty (Tags::randomRate, params.randomRate, nullptr);
-    state.setProperty (Tags::randomAmount, params.randomAmount, nullptr);
-    state.setProperty (Tags::randomFilters, params.randomFilters, nullptr);
-    state.setProperty (Tags::crossfadeRate, params.crossfadeRate, nullptr);
-    state.setProperty (Tags::enabledAllPasses, allpasses.toString (2), nullptr);
-    state.setProperty (Tags::enabledCombs, combs.toString (2), nullptr);
     state.addListener (this);
 }
 
+void Processor::copyParametersToState() {
+    state.setProperty (Tags::roomSize, roomSize->get(), nullptr);
+    state.setProperty (Tags::damping, damping->get(), nullptr);
+    state.setProperty (Tags::wetLevel, wetLevel->get(), nullptr);
+    state.setProperty (Tags::dryLevel, dryLevel->get(), nullptr);
+    state.setProperty (Tags::width, width->get(), nullptr);
+    state.setProperty (Tags::freezeMode, freezeMode->get() ? 1.0f : 0.0f, nullptr);
+    state.setProperty (Tags::randomEnabled, randomEnabled->get() ? 1.0f : 0.0f, nullptr);
+    state.setProperty (Tags::randomRate, (float) randomRate->getIndex(), nullptr);
+    state.setProperty (Tags::randomAmount, randomAmount->get(), nullptr);
+    state.setProperty (Tags::randomFilters, (float) randomFilters->getIndex(), nullptr);
+    state.setProperty (Tags::crossfadeRate, (float) crossfadeRate->getIndex(), nullptr);
+    state.setProperty (Tags::fadeCurve, (float) fadeCurve->getIndex(), nullptr);
+    state.setProperty (Tags::delayFormat, delayFormat->getIndex(), nullptr);
+    state.setProperty (Tags::decimated, decimated->get(), nullptr);
+    state.setProperty (Tags::combTier, combTier->getIndex(), nullptr);
+}
+
 void Processor::valueTreePropertyChanged (ValueTree& tree, const Identifier& property) {
     const var& value (tree.getProperty (property));
 
+    // changes from the UI or a loaded state go to the parameters, so the
+    // host sees them too
     if (property == Tags::roomSize) {
-        setParameter (SyncRoboVerb::RoomSize, (float) value);
+        *roomSize = (float) value;
     } else if (property == Tags::damping) {
-        setParameter (SyncRoboVerb::Damping, (float) value);
+        *damping = (float) value;
     } else if (property == Tags::dryLevel) {
-        setParameter (SyncRoboVerb::DryLevel, (float) value);
+        *dryLevel = (float) value;
     } else if (property == Tags::wetLevel) {
-        setParameter (SyncRoboVerb::WetLevel, (float) value);
+        *wetLevel = (float) value;
     } else if (property == Tags::freezeMode) {
-        setParameter (SyncRoboVerb::FreezeMode, (float) value);
+        *freezeMode = (float) value >= 0.5f;
     } else if (property == Tags::width) {
-        setParameter (SyncRoboVerb::Width, (float) value);
+        *width = (float) value;
     } else if (property == Tags::randomEnabled) {
-        setParameter (SyncRoboVerb::RandomEnabled, (float) value);
+        *randomEnabled = (float) value >= 0.5f;
     } else if (property == Tags::randomRate) {
-        setParameter (SyncRoboVerb::RandomRate, (float) value);
+        *randomRate = (int) value;
     } else if (property == Tags::randomAmount) {
-        setParameter (SyncRoboVerb::RandomAmount, (float) value);
+        *randomAmount = (float) value;
     } else if (property == Tags::randomFilters) {
-        setParameter (SyncRoboVerb::RandomFilters, (float) value);
+        *randomFilters = (int) value;
     } else if (property == Tags::crossfadeRate) {
-        setParameter (SyncRoboVerb::CrossfadeRate, (float) value);
-    } else if (property == Tags::enabledCombs) {
-        BigInteger enabled;
-        enabled.parseString (value.toString(), 2);
-        ScopedLock sl (getCallbackLock());
-        verb.swapEnabledCombs (enabled);
-    } else if (property == Tags::enabledAllPasses) {
-        BigInteger enabled;
-        enabled.parseString (value.toString(), 2);
-        ScopedLock sl (getCallbackLock());
-        verb.swapEnabledAllPasses (enabled);
+        *crossfadeRate = (int) value;
+    } else if (property == Tags::switchMask) {
+        const int switches = (int) value & ((1 << numSwitches) - 1);
+        for (int i = 0; i < numSwitches; ++i)
+            *switchParams[(size_t) i] = ((switches >> i) & 1) != 0;
+        uiSwitches = switches;
+    } else if (property == Tags::delayFormat) {
+        *delayFormat = (int) value;
+    } else if (property == Tags::combTier) {
+        *combTier = (int) value;
+    } else if (property == Tags::decimated) {
+        *decimated = (bool) value;
+    } else if (property == Tags::fadeCurve) {
+        *fadeCurve = (int) value;
     }
 }
 
 void Processor::processPendingUIUpdates() {
-    if (hasPendingUIUpdate.get()) {
-        state.setProperty(Tags::enabledCombs, pendingCombsUpdate, nullptr);
-        state.setProperty(Tags::enabledAllPasses, pendingAllPassesUpdate, nullptr);
-        hasPendingUIUpdate = false;
+    // unchanged properties don't notify, so this only reaches the UI when
+    // something has moved; the engine already has all of it
+    state.removeListener (this);
+    copyParametersToState();
+    delete retiredNetwork.exchange (nullptr);
+
+    SwitchEventChannel::Event event;
+    if (switchEvents.readSince (lastSwitchEvent, event)) {
+        lastSwitchEvent = event.sequence;
+        state.setProperty (Tags::switchMask, (int) event.mask, nullptr);
     }
+
+    state.addListener (this);
 }
 } // namespace syncroboverb
 
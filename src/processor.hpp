@@ -3,14 +3,20 @@
 
 #pragma once
 
+#include <array>
+
 #include "juce.hpp"
 #include <juce_audio_processors/juce_audio_processors.h>
+#include "stalldetector.hpp"
+#include "switchevents.hpp"
 #include "syncroboverb.hpp"
 
 namespace syncroboverb {
 
 class Processor  : public AudioProcessor,
-                   public ValueTree::Listener
+                   public ValueTree::Listener,
+                   private AudioProcessorParameter::Listener,
+                   private AsyncUpdater
 {
 public:
     Processor();
@@ -21,19 +27,13 @@ public:
 
     void processBlock (AudioBuffer<float>&, MidiBuffer&) override;
     void processBlock (AudioBuffer<double>&, MidiBuffer&) override;
+    bool supportsDoublePrecisionProcessing() const override;
 
     AudioProcessorEditor* createEditor() override;
     bool hasEditor() const override;
 
     const String getName() const override;
 
-    int getNumParameters() override;
-    float getParameter (int index) override;
-    void setParameter (int index, float newValue) override;
-
-    String getParameterName (int index, int maxLen) override;
-    String getParameterText (int index, int maxLen) override;
-
     const String getInputChannelName (int channelIndex) const override;
     const String getOutputChannelName (int channelIndex) const override;
     bool isInputChannelStereoPair (int index) const override;
@@ -53,28 +53,86 @@ public:
     void getStateInformation (MemoryBlock& destData) override;
     void setStateInformation (const void* data, int sizeInBytes) override;
 
-    void updateParameters (SyncRoboVerb::Parameters& params);
     ValueTree getState() const { return state; }
 
     float getRMS() const { return rmsValue.get(); }
 
+    /** The memory held by the delay lines in use or about to be. */
+    int getDelayMemorySize() const { return delayMemorySize.get(); }
+
+    /** How much of the time available for each block processing takes, 0 to 1. */
+    double getProcessingLoad() const { return loadMeasurer.getLoadAsProportion(); }
+
 private:
-    const int numParameters;
-    const int numKnobs;
+    enum { numSwitches = SyncRoboVerb::numCombs + SyncRoboVerb::numAllPasses };
+
     ValueTree state;
-    SyncRoboVerb::Parameters params;
     SyncRoboVerb verb;
 
+    // owned by the processor once added, read by the audio thread each block
+    AudioParameterFloat* roomSize { nullptr };
+    AudioParameterFloat* damping { nullptr };
+    AudioParameterFloat* wetLevel { nullptr };
+    AudioParameterFloat* dryLevel { nullptr };
+    AudioParameterFloat* width { nullptr };
+    AudioParameterBool* freezeMode { nullptr };
+    AudioParameterBool* randomEnabled { nullptr };
+    AudioParameterChoice* randomRate { nullptr };
+    AudioParameterFloat* randomAmount { nullptr };
+    AudioParameterChoice* randomFilters { nullptr };
+    AudioParameterChoice* crossfadeRate { nullptr };
+    AudioParameterChoice* fadeCurve { nullptr };
+    std::array<AudioParameterBool*, numSwitches> switchParams {};
+
+    // not automatable, they reallocate the delay lines
+    AudioParameterChoice* delayFormat { nullptr };
+    AudioParameterBool* decimated { nullptr };
+    AudioParameterChoice* combTier { nullptr };
+
+    // the switches as the host last set them, so only the ones it moves are applied
+    uint16 hostSwitches { 0 };
+    // the editor's or a loaded session's switches, waiting for the audio thread, or -1
+    Atomic<int> uiSwitches { -1 };
+
+    // Changing these reallocates the delay lines. The message thread keeps
+    // the settings and prepares a network for them, the audio thread swaps
+    // it in and hands back the one it replaced, which the message thread
+    // frees; neither waits for the other. The latency of the network
+    // playing is reported to the host from the message thread.
+    SyncRoboVerb::NetworkSettings networkSettings;
+    Atomic<SyncRoboVerb::PreparedNetwork*> pendingNetwork { nullptr };
+    Atomic<SyncRoboVerb::PreparedNetwork*> retiredNetwork { nullptr };
+    Atomic<int> delayMemorySize { 0 };
+    Atomic<int> networkLatency { 0 };
+
+    double lastPpqPosition { -1.0 };
+    double nextPpqPosition { -1.0 };
+
     Atomic<float> rmsValue;
+    AudioProcessLoadMeasurer loadMeasurer;
+    DenormalStallDetector stallDetector;
 
-    // For reliable UI updates from audio thread
-    String pendingCombsUpdate;
-    String pendingAllPassesUpdate; 
-    Atomic<bool> hasPendingUIUpdate { false };
+    // switches the randomizer or the host flips, on their way to the UI
+    SwitchEventChannel switchEvents;
+    uint16 publishedSwitches { 0 };
+    uint32 lastSwitchEvent { 0 };
+    int64 numSamplesProcessed { 0 };
 
     void updateState();
+    void copyParametersToState();
+    SyncRoboVerb::Parameters readParameters() const noexcept;
+    void applyParameters();
+    SyncRoboVerb::NetworkSettings readNetworkSettings() const noexcept;
+    void requestNetwork();
+    void installPendingNetwork() noexcept;
+    void freeNetworks();
+
+    template <typename SampleType>
+    void process (AudioBuffer<SampleType>& buffer);
     
 public:
+    /** Message thread: copies parameters the host has automated and switches
+        the randomizer has flipped into the state. */
     void processPendingUIUpdates();
     
 private:
@@ -85,6 +143,10 @@ private:
     void valueTreeChildOrderChanged (ValueTree&, int, int) override {}
     void valueTreeParentChanged (ValueTree&) override {}
     void valueTreeRedirected (ValueTree&) override { }
+
+    void parameterValueChanged (int, float) override { triggerAsyncUpdate(); }
+    void parameterGestureChanged (int, bool) override {}
+    void handleAsyncUpdate() override;
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Processor)
 };
 }
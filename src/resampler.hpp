@@ -0,0 +1,243 @@
+// Copyright (C) 2015-2025  Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#pragma once
+
+#include <cmath>
+#include <cstring>
+#include <utility>
+
+#include <juce_core/juce_core.h>
+
+/** The lowpass shared by the decimator and the interpolator.
+
+    A linear phase Blackman windowed sinc of tapsPerPhase taps per phase, cut
+    off a little below the Nyquist frequency of the low rate so what folds
+    back on the way down lands above 20kHz. Going down and back up through it
+    delays the signal by getLatencyFor() samples of the high rate.
+*/
+struct PolyphaseLowpass {
+    enum { tapsPerPhase = 32 };
+
+    static constexpr int getNumTapsFor (const int factor) noexcept { return tapsPerPhase * factor; }
+
+    static constexpr int getLatencyFor (const int factor) noexcept {
+        return factor > 1 ? getNumTapsFor (factor) - 1 : 0;
+    }
+
+    /** Returns the sum of a[i] * b[i], for a multiple of 8 terms. The sum is
+        split over eight accumulators so it vectorizes without relaxed
+        floating point flags. */
+    static float dotProduct (const float* a, const float* b, const int numTerms) noexcept {
+        jassert (numTerms % 8 == 0);
+        float sums[8] {};
+        for (int i = 0; i < numTerms; i += 8)
+            for (int j = 0; j < 8; ++j)
+                sums[j] += a[i + j] * b[i + j];
+        return ((sums[0] + sums[4]) + (sums[1] + sums[5])) + ((sums[2] + sums[6]) + (sums[3] + sums[7]));
+    }
+
+    /** Fills coeffs with the filter for a factor, with unity gain at DC. */
+    static void design (float* const coeffs, const int factor) noexcept {
+        const int numTaps = getNumTapsFor (factor);
+        const double cutoff = 0.45 / factor;
+        const double centre = 0.5 * (numTaps - 1);
+        const double pi = juce::MathConstants<double>::pi;
+        double sum = 0.0;
+
+        for (int k = 0; k < numTaps; ++k) {
+            const double t = k - centre;
+            const double sinc = juce::exactlyEqual (t, 0.0) ? 2.0 * cutoff : std::sin (2.0 * pi * cutoff * t) / (pi * t);
+            const double w = 2.0 * pi * k / (numTaps - 1);
+            const double window = 0.42 - 0.5 * std::cos (w) + 0.08 * std::cos (2.0 * w);
+            coeffs[k] = (float) (sinc * window);
+            sum += sinc * window;
+        }
+
+        for (int k = 0; k < numTaps; ++k)
+            coeffs[k] = (float) (coeffs[k] / sum);
+    }
+};
+
+//==============================================================================
+/** Lowpasses a signal and keeps every factor-th sample.
+
+    Only the kept outputs are evaluated, so this costs tapsPerPhase
+    multiply-adds per input sample. The history is stored twice over so the
+    taps of any output are contiguous.
+*/
+class PolyphaseDecimator {
+public:
+    PolyphaseDecimator() = default;
+
+    void prepare (const int newFactor) {
+        factor = newFactor;
+        numTaps = PolyphaseLowpass::getNumTapsFor (factor);
+        coeffs.allocate ((size_t) numTaps, true);
+        history.allocate ((size_t) numTaps * 2, true);
+        PolyphaseLowpass::design (coeffs, factor);
+        reset();
+    }
+
+    void reset() noexcept {
+        if (history != nullptr)
+            memset (history, 0, sizeof (float) * (size_t) numTaps * 2);
+        pos = phase = 0;
+    }
+
+    /** Reads numSamples from input and writes the samples kept to output.
+        Returns how many were written, which is numSamples / factor give or
+        take one depending on where the previous call left off. */
+    template <typename SampleType>
+    int process (const SampleType* input, SampleType* output, const int numSamples) noexcept {
+        int numOut = 0;
+
+        for (int i = 0; i < numSamples; ++i) {
+            pos = (pos == 0 ? numTaps : pos) - 1;
+            history[pos] = history[pos + numTaps] = (float) input[i];
+
+            if (phase == 0)
+                output[numOut++] = (SampleType) PolyphaseLowpass::dotProduct (coeffs, history + pos, numTaps);
+
+            if (++phase == factor)
+                phase = 0;
+        }
+
+        return numOut;
+    }
+
+    /** Exchanges filters and state with another decimator, without allocating. */
+    void swapWith (PolyphaseDecimator& other) noexcept {
+        coeffs.swapWith (other.coeffs);
+        history.swapWith (other.history);
+        std::swap (factor, other.factor);
+        std::swap (numTaps, other.numTaps);
+        std::swap (pos, other.pos);
+        std::swap (phase, other.phase);
+    }
+
+private:
+    juce::HeapBlock<float> coeffs, history;
+    int factor { 1 };
+    int numTaps { 0 };
+    int pos { 0 };
+    int phase { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE (PolyphaseDecimator)
+};
+
+//==============================================================================
+/** Raises a signal by an integer factor, the inverse of PolyphaseDecimator.
+
+    The lowpass is split into factor phases and each output sample runs the
+    one phase that's due over the last tapsPerPhase input samples. A decimator
+    and interpolator prepared with the same factor, and fed the same block
+    lengths, stay in step: the interpolator takes a new input exactly when the
+    decimator has written one.
+*/
+class PolyphaseInterpolator {
+public:
+    PolyphaseInterpolator() = default;
+
+    void prepare (const int newFactor) {
+        factor = newFactor;
+        const int numTaps = PolyphaseLowpass::getNumTapsFor (factor);
+        juce::HeapBlock<float> prototype ((size_t) numTaps);
+        PolyphaseLowpass::design (prototype, factor);
+
+        // phase p takes taps p, p + factor, p + 2 * factor... with the gain
+        // lost to the zeros in between put back
+        phases.allocate ((size_t) numTaps, true);
+        for (int p = 0; p < factor; ++p)
+            for (int t = 0; t < tapsPerPhase; ++t)
+                phases[p * tapsPerPhase + t] = prototype[t * factor + p] * (float) factor;
+
+        reset();
+    }
+
+    void reset() noexcept {
+        memset (history, 0, sizeof (history));
+        pos = phase = 0;
+    }
+
+    /** Writes numSamples to output, reading one input sample every factor outputs. */
+    template <typename SampleType>
+    void process (const SampleType* input, SampleType* output, const int numSamples) noexcept {
+        for (int i = 0; i < numSamples; ++i) {
+            if (phase == 0) {
+                pos = (pos == 0 ? (int) tapsPerPhase : pos) - 1;
+                history[pos] = history[pos + tapsPerPhase] = (float) *input++;
+            }
+
+            output[i] = (SampleType) PolyphaseLowpass::dotProduct (phases + phase * tapsPerPhase, history + pos,
+                                                                   tapsPerPhase);
+
+            if (++phase == factor)
+                phase = 0;
+        }
+    }
+
+    void swapWith (PolyphaseInterpolator& other) noexcept {
+        phases.swapWith (other.phases);
+        std::swap (history, other.history);
+        std::swap (factor, other.factor);
+        std::swap (pos, other.pos);
+        std::swap (phase, other.phase);
+    }
+
+private:
+    enum { tapsPerPhase = PolyphaseLowpass::tapsPerPhase };
+
+    juce::HeapBlock<float> phases;
+    float history[tapsPerPhase * 2] {};
+    int factor { 1 };
+    int pos { 0 };
+    int phase { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE (PolyphaseInterpolator)
+};
+
+//==============================================================================
+/** Delays the dry signal by the resampling latency so it lines up with the wet.
+    Held in double, so either precision comes through untouched. */
+class CompensationDelay {
+public:
+    CompensationDelay() = default;
+
+    void prepare (const int numSamples) {
+        length = numSamples;
+        buffer.allocate ((size_t) juce::jmax (1, length), true);
+        reset();
+    }
+
+    void reset() noexcept {
+        if (buffer != nullptr)
+            memset (buffer, 0, sizeof (double) * (size_t) juce::jmax (1, length));
+        pos = 0;
+    }
+
+    template <typename SampleType>
+    SampleType process (const SampleType sample) noexcept {
+        if (length == 0)
+            return sample;
+
+        const double delayed = buffer[pos];
+        buffer[pos] = (double) sample;
+        if (++pos == length)
+            pos = 0;
+        return (SampleType) delayed;
+    }
+
+    void swapWith (CompensationDelay& other) noexcept {
+        buffer.swapWith (other.buffer);
+        std::swap (length, other.length);
+        std::swap (pos, other.pos);
+    }
+
+private:
+    juce::HeapBlock<double> buffer;
+    int length { 0 };
+    int pos { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE (CompensationDelay)
+};
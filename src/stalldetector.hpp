@@ -0,0 +1,92 @@
+// Copyright (C) 2015-2025  Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+/** Watches block times for denormal stalls.
+
+    A reverb ringing out on silent input decays towards zero and, without
+    flush-to-zero, eventually runs on denormals at many times the normal
+    cost. The detector keeps a running cost per sample of blocks with input,
+    and counts a stall whenever a block of silent input costs more than
+    stallRatio times that. It's there to measure tails rather than guess at
+    them: on in debug builds, or in any build with SYNCROBOVERB_STALL_CHECK
+    set, with the summary going to juce::Logger. Each block costs two reads
+    of the tick counter. Blocks the reverb skipped its filters for, once a
+    tail has died away, aren't timed at all: they'd only flatter the tail.
+*/
+class DenormalStallDetector {
+public:
+    static constexpr double stallRatio = 3.0;
+
+    DenormalStallDetector() = default;
+
+    void setEnabled (const bool shouldBeEnabled) noexcept { enabled = shouldBeEnabled; }
+    bool isEnabled() const noexcept { return enabled; }
+
+    /** Returns true if the detector should run, see the class description. */
+    static bool isRequested() {
+       #if JUCE_DEBUG
+        return true;
+       #else
+        return juce::SystemStats::getEnvironmentVariable ("SYNCROBOVERB_STALL_CHECK", {}).isNotEmpty();
+       #endif
+    }
+
+    void reset() noexcept {
+        referenceCost = 0.0;
+        numTailBlocks = 0;
+        numStalls = 0;
+        worstRatio = 0.0f;
+    }
+
+    void blockStarted() noexcept {
+        if (enabled)
+            startTicks = juce::Time::getHighResolutionTicks();
+    }
+
+    /** Call after processing, with whether the block's input was silent and
+        whether the filters were skipped. */
+    void blockFinished (const int numSamples, const bool inputSilent, const bool skipped) noexcept {
+        if (! enabled || numSamples <= 0 || skipped)
+            return;
+
+        const double cost = (double) (juce::Time::getHighResolutionTicks() - startTicks) / numSamples;
+
+        if (! inputSilent) {
+            referenceCost = referenceCost > 0.0 ? referenceCost + 0.05 * (cost - referenceCost) : cost;
+            return;
+        }
+
+        if (referenceCost <= 0.0)
+            return;
+
+        const float ratio = (float) (cost / referenceCost);
+        numTailBlocks = numTailBlocks.get() + 1;
+        if (ratio > stallRatio)
+            numStalls = numStalls.get() + 1;
+        if (ratio > worstRatio.get())
+            worstRatio = ratio;
+    }
+
+    /** Returns how many blocks of silent input have been timed since reset(). */
+    int getNumTailBlocks() const noexcept { return numTailBlocks.get(); }
+
+    /** Returns how many of those took stallRatio times longer than usual. */
+    int getNumStalls() const noexcept { return numStalls.get(); }
+
+    /** Returns the slowest tail block, relative to blocks with input. */
+    float getWorstRatio() const noexcept { return worstRatio.get(); }
+
+private:
+    bool enabled { false };
+    juce::int64 startTicks { 0 };
+    double referenceCost { 0.0 };
+    juce::Atomic<int> numTailBlocks { 0 };
+    juce::Atomic<int> numStalls { 0 };
+    juce::Atomic<float> worstRatio { 0.0f };
+
+    JUCE_DECLARE_NON_COPYABLE (DenormalStallDetector)
+};
@@ -0,0 +1,55 @@
+// Copyright (C) 2015-2025  Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+/** Tells the UI when the audio thread has flipped switches on its own.
+
+    The audio thread publishes the whole switch mask with the sample it took
+    effect at; the UI polls for anything newer than what it last saw. Only
+    the newest event is kept, since that's all the UI has to show. Publishing
+    is three atomic stores and never allocates or waits. Reading retries for
+    as long as a publish is half done, with the sequence odd in the meantime.
+*/
+class SwitchEventChannel {
+public:
+    struct Event {
+        juce::uint16 mask { 0 };    /**< Combs in the low 8 bits, allpasses in the 4 above. */
+        juce::int64 timestamp { 0 }; /**< The sample the switches flipped at. */
+        juce::uint32 sequence { 0 }; /**< Counts up from 1 with each publish. */
+    };
+
+    SwitchEventChannel() = default;
+
+    /** Audio thread: publishes a new mask. */
+    void publish (const juce::uint16 mask, const juce::int64 timestamp) noexcept {
+        const juce::uint32 seq = sequence.get();
+        sequence = seq + 1;
+        publishedMask = (int) mask;
+        publishedTimestamp = timestamp;
+        sequence = seq + 2;
+    }
+
+    /** Fills event with the newest publish and returns true if it's newer
+        than lastSequence. */
+    bool readSince (const juce::uint32 lastSequence, Event& event) const noexcept {
+        juce::uint32 seq;
+        do {
+            seq = sequence.get();
+            event.mask = (juce::uint16) publishedMask.get();
+            event.timestamp = publishedTimestamp.get();
+        } while ((seq & 1) != 0 || seq != sequence.get());
+
+        event.sequence = seq / 2;
+        return event.sequence != lastSequence;
+    }
+
+private:
+    juce::Atomic<juce::uint32> sequence { 0 };
+    juce::Atomic<int> publishedMask { 0 };
+    juce::Atomic<juce::int64> publishedTimestamp { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE (SwitchEventChannel)
+};
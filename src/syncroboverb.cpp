@@ -3,71 +3,87 @@
 
 #include "syncroboverb.hpp"
 
-void TempoSyncedRandomizer::processTempo(double bpm, double ppqPosition, SyncRoboVerb& verb) {
-    if (!enabled) return;
+int TempoSyncedRandomizer::processTempo(double bpm, double ppqPosition, double ppqPerSample, int numSamples,
+                                        SyncRoboVerb& verb) {
+    if (!enabled) {
+        if (warming) {
+            verb.warmFilters(0);
+            warming = false;
+        }
+        return numSamples;
+    }
+    
+    const double interval = getRateInQuarterNotes();
+    const double warmUpBeats = juce::jmin(interval, warmUpSeconds * bpm / 60.0);
     
-    double interval = getRateInQuarterNotes();
+    // Within half a sample counts as on a boundary, so rounding in where the
+    // caller splits its block can't miss one or take it twice
+    const double tolerance = 0.5 * ppqPerSample;
     
-    // Check if we've moved past the next trigger point
-    if (ppqPosition - lastPpqPosition >= interval) {
-        randomizeSwitches(verb);
-        lastPpqPosition = ppqPosition;
-        switchesChanged = true;  // Mark that switches have been randomized
+    // setAmount() and setFilterType() throw the drawn pattern away, so the
+    // filters being warmed for it are let go before the next one is drawn
+    if (!hasNextFlips) {
+        if (warming)
+            verb.warmFilters(0);
+        drawNextFlips();
+        warming = false;
     }
-}
-
-void TempoSyncedRandomizer::randomizeSwitches(SyncRoboVerb& verb) {
-    if (amount <= 0.0f) return;
     
-    switch (filterType) {
-        case CombsOnly:
-            for (int i = 0; i < SyncRoboVerb::numCombs; ++i) {
-                if (rng.nextFloat() < amount) {
-                    bool currentState = verb.toggledCombFloat(i) > 0.5f;
-                    verb.setCombToggle(i, !currentState);
-                }
-            }
-            break;
-            
-        case AllPassOnly:
-            for (int i = 0; i < SyncRoboVerb::numAllPasses; ++i) {
-                if (rng.nextFloat() < amount) {
-                    bool currentState = verb.toggledAllPassFloat(i) > 0.5f;
-                    verb.setAllPassToggle(i, !currentState);
-                }
-            }
-            break;
-            
-        case Both:
-        default:
-            // Randomize comb filters
-            for (int i = 0; i < SyncRoboVerb::numCombs; ++i) {
-                if (rng.nextFloat() < amount) {
-                    bool currentState = verb.toggledCombFloat(i) > 0.5f;
-                    verb.setCombToggle(i, !currentState);
-                }
-            }
-            // Randomize all-pass filters
-            for (int i = 0; i < SyncRoboVerb::numAllPasses; ++i) {
-                if (rng.nextFloat() < amount) {
-                    bool currentState = verb.toggledAllPassFloat(i) > 0.5f;
-                    verb.setAllPassToggle(i, !currentState);
-                }
-            }
-            break;
+    // Pick up the grid again after a reset, or if the transport has jumped.
+    // A boundary passed by less than an interval, when the host's tempo ran
+    // ahead of ours, is taken late rather than dropped.
+    if (!hasNextTrigger || ppqPosition > nextTriggerPpq + interval
+        || ppqPosition < nextTriggerPpq - interval - tolerance) {
+        nextTriggerPpq = std::ceil((ppqPosition - tolerance) / interval) * interval;
+        hasNextTrigger = true;
     }
+    
+    if (nextTriggerPpq - ppqPosition <= tolerance) {
+        applyNextFlips(verb);
+        drawNextFlips();
+        nextTriggerPpq += interval;
+    }
+    
+    if (!warming && nextTriggerPpq - warmUpBeats - ppqPosition <= tolerance)
+        warmNextFlips(verb);
+    
+    if (ppqPerSample <= 0.0)
+        return numSamples;
+    
+    const double beatsToNext = nextTriggerPpq - ppqPosition - (warming ? 0.0 : warmUpBeats);
+    return (int) juce::jlimit(1.0, (double) numSamples, std::ceil(beatsToNext / ppqPerSample - 0.5));
 }
 
-void TempoSyncedRandomizer::getUpdatedSwitchStates(SyncRoboVerb& verb, BigInteger& combs, BigInteger& allpasses) {
-    // Get current switch states from the reverb object
-    combs.clear();
-    allpasses.clear();
+void TempoSyncedRandomizer::drawNextFlips() {
+    nextFlips = 0;
+    hasNextFlips = true;
+    
+    if (amount <= 0.0f) return;
     
-    for (int i = 0; i < SyncRoboVerb::numCombs; ++i) {
-        combs.setBit(i, verb.toggledCombFloat(i) > 0.5f);
+    if (filterType != AllPassOnly) {
+        for (int i = 0; i < SyncRoboVerb::numCombs; ++i)
+            if (rng.nextFloat() < amount)
+                nextFlips |= SyncRoboVerb::combBit(i);
     }
     
-    for (int i = 0; i < SyncRoboVerb::numAllPasses; ++i) {
-        allpasses.setBit(i, verb.toggledAllPassFloat(i) > 0.5f);
+    if (filterType != CombsOnly) {
+        for (int i = 0; i < SyncRoboVerb::numAllPasses; ++i)
+            if (rng.nextFloat() < amount)
+                nextFlips |= SyncRoboVerb::allPassBit(i);
     }
 }
+
+void TempoSyncedRandomizer::applyNextFlips(SyncRoboVerb& verb) {
+    verb.setSwitchMask(verb.getSwitchMask() ^ nextFlips);
+    
+    // The warmed filters are switched on now, fading in over their tails
+    verb.warmFilters(0);
+    warming = false;
+}
+
+void TempoSyncedRandomizer::warmNextFlips(SyncRoboVerb& verb) {
+    // Only filters that are off now get turned on by a flip, and warmFilters()
+    // leaves the ones already on alone
+    verb.warmFilters(nextFlips);
+    warming = true;
+}
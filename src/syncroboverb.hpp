@@ -3,13 +3,20 @@
 
 #pragma once
 
+#include <array>
 #include <cmath>
 #include <cstring>
 #include <memory>
+#include <type_traits>
+#include <utility>
 
 #include <juce_core/juce_core.h>
 
-using juce::BigInteger;
+#include "delayline.hpp"
+#include "fade.hpp"
+#include "kernels.hpp"
+#include "resampler.hpp"
+
 using juce::Identifier;
 
 namespace Tags {
@@ -19,15 +26,47 @@ static const Identifier wetLevel = "wetLevel";
 static const Identifier dryLevel = "dryLevel";
 static const Identifier width = "width";
 static const Identifier freezeMode = "freezeMode";
-static const Identifier enabledCombs = "enabledCombs";
-static const Identifier enabledAllPasses = "enabledAllPasses";
+static const Identifier switchMask = "switchMask";
+static const Identifier enabledCombs = "enabledCombs";         /**< Binary string, read from older sessions */
+static const Identifier enabledAllPasses = "enabledAllPasses"; /**< Binary string, read from older sessions */
 static const Identifier randomEnabled = "randomEnabled";
 static const Identifier randomRate = "randomRate";
 static const Identifier randomAmount = "randomAmount";
 static const Identifier randomFilters = "randomFilters";
 static const Identifier crossfadeRate = "crossfadeRate";
+static const Identifier delayFormat = "delayFormat";
+static const Identifier decimated = "decimated";
+static const Identifier fadeCurve = "fadeCurve";
+static const Identifier combTier = "combTier";
 }; // namespace Tags
 
+/** Filter delay tunings, in samples at the reference rate. */
+namespace Tunings {
+//static constexpr short combs[] = { 1116, 1188, 1277, 1356, 1422, 1491, 1557, 1617 }; // (at 44100Hz)
+static constexpr short combs[] = { 8092, 4096, 2048, 1024, 512, 256, 128, 64 }; // (at 44100Hz)
+static constexpr short allPasses[] = { 556, 441, 341, 225 };
+/** The denser comb tiers run copies of each comb detuned by these, in parts
+    per thousand, so the copies' echoes fall between each other's. */
+static constexpr short combSpreads[] = { 1000, 1053, 947, 1109 };
+static constexpr int stereoSpread = 23;
+static constexpr int referenceRate = 44100;
+
+/** Scales a tuning to a sample rate, the right channel being spread a little longer. */
+constexpr int scale (const int tuning, const int channel, const int sampleRate) noexcept {
+    return (int) (((juce::int64) sampleRate * (tuning + channel * stereoSpread)) / referenceRate);
+}
+} // namespace Tunings
+
+/** How many combs each comb switch runs, for a denser tail. The comb work
+    grows with the comb count: each tier doubles it. */
+enum class CombTier { standard = 0, dense, densest, numTiers };
+
+constexpr int getCombsPerSwitch (const CombTier tier) noexcept { return 1 << (int) tier; }
+
+inline const char* getCombTierName (const CombTier tier) noexcept {
+    return tier == CombTier::standard ? "standard" : (tier == CombTier::dense ? "dense" : "densest");
+}
+
 class TempoSyncedRandomizer {
 public:
     enum RandomRate {
@@ -54,26 +93,33 @@ public:
     }
     
     void reset() {
-        lastPpqPosition = 0.0;
+        nextTriggerPpq = 0.0;
+        hasNextTrigger = false;
         enabled = false;
         rate = QuarterNote;
         amount = 0.5f;
         filterType = Both;
-        switchesChanged = false;
+        nextFlips = 0;
+        hasNextFlips = false;
+        warming = false;
     }
     
     void setEnabled(bool shouldBeEnabled) { 
         enabled = shouldBeEnabled; 
-        if (enabled) lastPpqPosition = 0.0; // Reset timing when enabled
+        if (enabled) hasNextTrigger = false; // Pick up the grid again when enabled
     }
     void setRate(RandomRate newRate) { 
         rate = newRate; 
-        lastPpqPosition = 0.0; // Reset timing when rate changes
+        hasNextTrigger = false; // Pick up the grid again when rate changes
+    }
+    void setAmount(float newAmount) {
+        amount = juce::jlimit(0.0f, 1.0f, newAmount);
+        hasNextFlips = false; // Redraw the next pattern with the new amount
     }
-    void setAmount(float newAmount) { amount = juce::jlimit(0.0f, 1.0f, newAmount); }
     void setFilterType(FilterType newType) { 
         filterType = newType; 
-        lastPpqPosition = 0.0; // Reset timing when filter type changes
+        hasNextTrigger = false; // Pick up the grid again when filter type changes
+        hasNextFlips = false;
     }
     
     bool isEnabled() const { return enabled; }
@@ -81,26 +127,33 @@ public:
     float getAmount() const { return amount; }
     FilterType getFilterType() const { return filterType; }
     
-    void processTempo(double bpm, double ppqPosition, class SyncRoboVerb& verb);
+    /** How long before a switch the filters it will turn on are fed input,
+        muted, so they come in with a tail. Cut to the rate at fast rates. */
+    static constexpr double warmUpSeconds = 0.2;
     
-    // Get the updated switch states after randomization for UI updates
-    void getUpdatedSwitchStates(class SyncRoboVerb& verb, BigInteger& combs, BigInteger& allpasses);
-    
-    // Check if switches have changed and clear the flag
-    bool checkAndClearSwitchesChanged() {
-        bool changed = switchesChanged;
-        switchesChanged = false;
-        return changed;
-    }
+    /** Runs the randomizer over the host's timeline from ppqPosition, flipping
+        switches if a boundary of the rate's grid falls on it, or warming them
+        if a warm up starts there. Returns how many samples the caller can
+        render before the next of those, at most numSamples, so a block split
+        there has its switches flip on the right sample whatever the block
+        size. ppqPerSample is 0 while the transport is stopped. */
+    int processTempo(double bpm, double ppqPosition, double ppqPerSample, int numSamples,
+                     class SyncRoboVerb& verb);
     
 private:
     bool enabled;
     RandomRate rate;
     float amount;
     FilterType filterType;
-    double lastPpqPosition;
+    double nextTriggerPpq;
+    bool hasNextTrigger;
     juce::Random rng;
-    bool switchesChanged;
+    
+    // The switches to flip at the next trigger, as a switch mask, drawn an
+    // interval ahead so the filters they turn on can be warmed up first
+    juce::uint16 nextFlips;
+    bool hasNextFlips;
+    bool warming;
     
     double getRateInQuarterNotes() const {
         switch (rate) {
@@ -116,7 +169,9 @@ private:
         }
     }
     
-    void randomizeSwitches(class SyncRoboVerb& verb);
+    void drawNextFlips();
+    void applyNextFlips(class SyncRoboVerb& verb);
+    void warmNextFlips(class SyncRoboVerb& verb);
 };
 
 class TempoSyncedCrossfadeManager {
@@ -131,7 +186,7 @@ public:
         numTimings
     };
     
-    TempoSyncedCrossfadeManager() : crossfadeTiming(Thirtysecond), currentBPM(150.0), sampleRate(44100.0) {}
+    TempoSyncedCrossfadeManager() : crossfadeTiming(Thirtysecond), fadeCurve(FadeCurve::equalPower), currentBPM(150.0), sampleRate(44100.0) {}
     
     void updateTempo(double bpm, double sr) {
         currentBPM = bpm;
@@ -143,6 +198,9 @@ public:
     }
     
     CrossfadeTiming getCrossfadeTiming() const { return crossfadeTiming; }
+
+    void setFadeCurve (FadeCurve curve) { fadeCurve = curve; }
+    FadeCurve getFadeCurve() const { return fadeCurve; }
     
     int calculateFadeSamples() const {
         if (crossfadeTiming == Immediate) {
@@ -156,6 +214,7 @@ public:
     
 private:
     CrossfadeTiming crossfadeTiming;
+    FadeCurve fadeCurve;
     double currentBPM;
     double sampleRate;
     
@@ -186,25 +245,47 @@ public:
         RandomFilters,
         CrossfadeRate,
         numParameters,
-        numCombs = 8,
+        numCombs = 8, /**< The comb switches, each running getCombsPerSwitch() combs */
+        maxCombs = numCombs * 4,
         numAllPasses = 4,
-        numChannels = 2
+        numChannels = 2,
+        numDelayLines = numChannels * (maxCombs + numAllPasses),
+        blockSize = 256
     };
 
+    /** Input and delay lines below this level, -160dB, can't add up to
+        anything above -120dB at the output, so are taken as silent. */
+    static constexpr float silenceThreshold = 1.0e-8f;
+
+    /** The gain into the combs, and the feedback the room size sweeps them over. */
+    static constexpr float inputGain = 0.015f;
+    static constexpr double roomScaleFactor = 0.28;
+    static constexpr double roomOffset = 0.7;
+
+    // a comb resonating with both inputs at full scale in the largest room
+    // builds up to their sum times inputGain / (1 - feedback), which has to
+    // fit int16 storage's full scale
+    static_assert (kernels::Storage<std::int16_t>::fullScale
+                       >= 2.0 * inputGain / (1.0 - (roomScaleFactor + roomOffset)),
+                   "int16 delay lines clip a comb at resonance");
+
     SyncRoboVerb() {
-        for (int i = 0; i < numCombs; ++i)
-            enabledCombs[i] = false;
-        enabledCombs[3] = true;
-        enabledCombs[4] = true;
-        enabledCombs[5] = true;
+        switches = combBit (3) | combBit (4) | combBit (5) | allPassBit (0) | allPassBit (1);
 
+        // the filters start at their switches' gains, with nothing to fade from
+        for (int i = 0; i < numCombs; ++i)
+            combs.startFade (i, isCombOn (i), 0, FadeCurve::linear);
         for (int i = 0; i < numAllPasses; ++i)
-            enabledAllPasses[i] = false;
-        enabledAllPasses[0] = true;
-        enabledAllPasses[1] = true;
+            for (int ch = 0; ch < numChannels; ++ch)
+                allPass[ch][i].startFade (isAllPassOn (i), 0, FadeCurve::linear);
 
+        combs.updateActiveLanes();
+        updateAllPassMasks();
         setParameters (Parameters());
         setSampleRate (44100.0);
+
+        // builds the fade tables here rather than on the audio thread
+        FadeTables::get (FadeCurve::linear, true);
     }
 
     /** Holds the parameters being used by a Reverb object. */
@@ -272,300 +353,1187 @@ public:
 
     const Parameters& getParameters() const noexcept { return parameters; }
 
-    void swapEnabledCombs (BigInteger& e) {
-        for (int i = 0; i < numCombs; ++i)
-            enabledCombs[i] = e[i];
-    }
-
-    void swapEnabledAllPasses (BigInteger& e) {
-        for (int i = 0; i < numAllPasses; ++i)
-            enabledAllPasses[i] = e[i];
+    /** A switch mask has the combs in the low 8 bits and the allpasses in
+        the 4 above, the order the switches are numbered in everywhere. */
+    static constexpr juce::uint16 combBit (const int index) noexcept { return (juce::uint16) (1u << index); }
+    static constexpr juce::uint16 allPassBit (const int index) noexcept {
+        return (juce::uint16) (1u << (numCombs + index));
     }
+    static constexpr juce::uint16 allSwitches = (1u << (numCombs + numAllPasses)) - 1;
 
-    void getEnablement (BigInteger& c, BigInteger& a) const {
-        for (int i = 0; i < numCombs; ++i)
-            c.setBit (i, enabledCombs[i]);
-        for (int i = 0; i < numAllPasses; ++i)
-            a.setBit (i, enabledAllPasses[i]);
-    }
+    juce::uint16 getSwitchMask() const noexcept { return switches; }
 
-    void setCombToggle (const int index, const bool toggled) {
-        enabledCombs[index] = toggled;
+    /** Fades in or out whichever filters differ from the mask. */
+    void setSwitchMask (const juce::uint16 newSwitches) noexcept {
+        switchFilters (newSwitches & allSwitches, crossfadeManager.calculateFadeSamples());
     }
 
-    void setAllPassToggle (const int index, const bool toggled) {
-        enabledAllPasses[index] = toggled;
+    /** Sets one switch, numbered as in the mask. */
+    void setSwitch (const int index, const bool toggled) noexcept {
+        const auto bit = (juce::uint16) (1u << index);
+        setSwitchMask (toggled ? (juce::uint16) (switches | bit) : (juce::uint16) (switches & ~bit));
     }
 
-    float toggledCombFloat (const int index) const {
-        return enabledCombs[index] ? 1.0f : 0.0f;
-    }
+    bool isCombOn (const int index) const noexcept { return (switches & combBit (index)) != 0; }
+    bool isAllPassOn (const int index) const noexcept { return (switches & allPassBit (index)) != 0; }
 
-    float toggledAllPassFloat (const int index) const {
-        return enabledAllPasses[index] ? 1.0f : 0.0f;
-    }
+    float toggledCombFloat (const int index) const { return isCombOn (index) ? 1.0f : 0.0f; }
+    float toggledAllPassFloat (const int index) const { return isAllPassOn (index) ? 1.0f : 0.0f; }
 
     void setParameters (const Parameters& newParams) {
-        const float wetScaleFactor = 6.0f;
-        const float dryScaleFactor = 2.0f;
+        const double wetScaleFactor = 6.0;
+        const double dryScaleFactor = 2.0;
 
-        const float wet = newParams.wetLevel * wetScaleFactor;
+        const double wet = newParams.wetLevel * wetScaleFactor;
         dryGain.setValue (newParams.dryLevel * dryScaleFactor);
-        wetGain1.setValue (0.5f * wet * (1.0f + newParams.width));
-        wetGain2.setValue (0.5f * wet * (1.0f - newParams.width));
+        wetGain1.setValue (0.5 * wet * (1.0 + newParams.width));
+        wetGain2.setValue (0.5 * wet * (1.0 - newParams.width));
 
-        gain = isFrozen (newParams.freezeMode) ? 0.0f : 0.015f;
+        gain = isFrozen (newParams.freezeMode) ? 0.0f : inputGain;
         parameters = newParams;
         updateDamping();
     }
 
-    void setSampleRate (const double sampleRate) {
-        //static const short combTunings[] = { 1116, 1188, 1277, 1356, 1422, 1491, 1557, 1617 }; // (at 44100Hz)
-        static const short combTunings[] = { 8092, 4096, 2048, 1024, 512, 256, 128, 64 }; // (at 44100Hz)
-        static const short allPassTunings[] = { 556, 441, 341, 225 };
-        const int stereoSpread = 23;
-        const int intSampleRate = (int) sampleRate;
+    /** The length of every delay line at one sample rate, in the order they're
+        laid out in the arena. */
+    struct DelayLayout {
+        int sampleRate { 0 };
+        std::array<int, numDelayLines> delays {};
+    };
 
-        for (int i = 0; i < numCombs; ++i) {
-            comb[0][i].setSize ((intSampleRate * combTunings[i]) / 44100);
-            comb[1][i].setSize ((intSampleRate * (combTunings[i] + stereoSpread)) / 44100);
+    /** Works out the layout for a sample rate. The arena is laid out in the
+        order the kernels walk the lines: the comb lanes, then each allpass
+        stage with its left and right lines side by side. Comb i is a copy of
+        switch i % numCombs's comb; only the combs of the tier in use are
+        given memory. */
+    static constexpr DelayLayout makeDelayLayout (const int intSampleRate) noexcept {
+        DelayLayout layout;
+        layout.sampleRate = intSampleRate;
+        int numLines = 0;
+
+        for (int ch = 0; ch < numChannels; ++ch) {
+            for (int i = 0; i < maxCombs; ++i) {
+                const int tuning = Tunings::combs[i % numCombs] * Tunings::combSpreads[i / numCombs] / 1000;
+                layout.delays[(size_t) numLines++] = Tunings::scale (tuning, ch, intSampleRate);
+            }
         }
 
-        for (int i = 0; i < numAllPasses; ++i) {
-            allPass[0][i].setSize ((intSampleRate * allPassTunings[i]) / 44100);
-            allPass[1][i].setSize ((intSampleRate * (allPassTunings[i] + stereoSpread)) / 44100);
+        for (int i = 0; i < numAllPasses; ++i)
+            for (int ch = 0; ch < numChannels; ++ch)
+                layout.delays[(size_t) numLines++] = Tunings::scale (Tunings::allPasses[i], ch, intSampleRate);
+
+        return layout;
+    }
+
+    /** Returns the compile time layout for 44.1/48/88.2/96/176.4/192kHz, or
+        nullptr for any other rate. */
+    static const DelayLayout* getStandardLayout (const int intSampleRate) noexcept {
+        static constexpr DelayLayout layouts[] = {
+            makeDelayLayout (44100), makeDelayLayout (48000), makeDelayLayout (88200),
+            makeDelayLayout (96000), makeDelayLayout (176400), makeDelayLayout (192000)
+        };
+
+        static_assert (layouts[0].delays[0] == Tunings::combs[0], "44.1kHz is the reference rate");
+
+        for (const auto& layout : layouts)
+            if (layout.sampleRate == intSampleRate)
+                return &layout;
+        return nullptr;
+    }
+
+    /** The settings that decide how the delay lines and resamplers are allocated. */
+    struct NetworkSettings {
+        DelayFormat delayFormat { DelayFormat::float32 };
+        CombTier combTier { CombTier::standard };
+        bool decimated { false };
+
+        bool operator== (const NetworkSettings& o) const noexcept {
+            return delayFormat == o.delayFormat && combTier == o.combTier && decimated == o.decimated;
         }
 
-        const double smoothTime = 0.01;
-        damping.reset (sampleRate, smoothTime);
-        feedback.reset (sampleRate, smoothTime);
-        dryGain.reset (sampleRate, smoothTime);
-        wetGain1.reset (sampleRate, smoothTime);
-        wetGain2.reset (sampleRate, smoothTime);
+        bool operator!= (const NetworkSettings& o) const noexcept { return ! operator== (o); }
+    };
+
+    /** The delay lines and resamplers for some NetworkSettings at a sample
+        rate. prepare() allocates them and swapNetwork() puts them in place
+        without allocating, so a change of settings can be built off the audio
+        thread and handed over to it. */
+    class PreparedNetwork {
+    public:
+        PreparedNetwork() = default;
+
+        void prepare (const NetworkSettings& settingsToUse, const double sampleRate) {
+            settings = settingsToUse;
+            hostSampleRate = sampleRate;
+            decimation = settings.decimated ? getDecimationFor (sampleRate) : 1;
+
+            const int intSampleRate = (int) (sampleRate / decimation);
+            if (const auto* standard = getStandardLayout (intSampleRate))
+                layout = *standard;
+            else
+                layout = makeDelayLayout (intSampleRate);
+
+            int delays[numDelayLines];
+            DelayFormat formats[numDelayLines];
+            const int numLines = getLinesInUse (layout, settings, delays, formats);
+            memory.prepare (formats, delays, numLines);
+
+            for (int ch = 0; ch < numChannels; ++ch) {
+                decimators[ch].prepare (decimation);
+                interpolators[ch].prepare (decimation);
+                dryDelays[ch].prepare (getLatencySamples());
+            }
+        }
+
+        const NetworkSettings& getSettings() const noexcept { return settings; }
+        double getSampleRate() const noexcept { return hostSampleRate; }
+        int getLatencySamples() const noexcept { return PolyphaseLowpass::getLatencyFor (decimation); }
+        size_t getDelayMemorySize() const noexcept { return memory.getSizeInBytes(); }
+
+    private:
+        friend class SyncRoboVerb;
+
+        NetworkSettings settings;
+        double hostSampleRate { 0.0 };
+        int decimation { 1 };
+        DelayLayout layout;
+        DelayArena memory;
+        PolyphaseDecimator decimators[numChannels];
+        PolyphaseInterpolator interpolators[numChannels];
+        CompensationDelay dryDelays[numChannels];
+
+        JUCE_DECLARE_NON_COPYABLE (PreparedNetwork)
+    };
+
+    /** Puts a prepared network in place, without allocating, and clears the
+        reverb. network is left holding the one it replaced, for the caller
+        to free. */
+    void swapNetwork (PreparedNetwork& network) noexcept {
+        std::swap (delayFormat, network.settings.delayFormat);
+        std::swap (combTier, network.settings.combTier);
+        std::swap (decimated, network.settings.decimated);
+        std::swap (hostSampleRate, network.hostSampleRate);
+        std::swap (decimation, network.decimation);
+        std::swap (delayLayout, network.layout);
+        delayMemory.swapWith (network.memory);
+
+        for (int ch = 0; ch < numChannels; ++ch) {
+            decimators[ch].swapWith (network.decimators[ch]);
+            interpolators[ch].swapWith (network.interpolators[ch]);
+            dryDelays[ch].swapWith (network.dryDelays[ch]);
+        }
+
+        installNetwork();
+    }
+
+    /** Prepares and swaps in a network straight away, for callers that are
+        allowed to allocate. */
+    void setNetwork (const NetworkSettings& settings, const double sampleRate) {
+        PreparedNetwork network;
+        network.prepare (settings, sampleRate);
+        swapNetwork (network);
+    }
+
+    NetworkSettings getNetworkSettings() const noexcept { return { delayFormat, combTier, decimated }; }
+
+    void setSampleRate (const double sampleRate) { setNetwork (getNetworkSettings(), sampleRate); }
+
+    /** Runs the wet path at 44.1 or 48kHz when the host rate is a multiple of
+        either. The network then needs the same memory and CPU at any host
+        rate, less the cost of resampling, in exchange for getLatencySamples()
+        of latency and no wet content above about 20kHz. */
+    void setDecimated (const bool shouldDecimate) {
+        if (shouldDecimate == decimated)
+            return;
+
+        auto settings = getNetworkSettings();
+        settings.decimated = shouldDecimate;
+        setNetwork (settings, hostSampleRate);
+    }
+
+    bool isDecimated() const noexcept { return decimated; }
+
+    /** Returns the factor the wet path is decimated by at a host rate: the
+        largest power of two leaving at least 44.1kHz. */
+    static int getDecimationFor (const double sampleRate) noexcept {
+        int factor = 1;
+        while (sampleRate / (factor * 2) >= 44100.0)
+            factor *= 2;
+        return factor;
+    }
+
+    /** Returns the rate the filters run at, which filter fade lengths should be worked out at. */
+    double getInternalSampleRate() const noexcept { return hostSampleRate / decimation; }
+
+    /** Returns the delay added by the resampling, in host rate samples. */
+    int getLatencySamples() const noexcept { return PolyphaseLowpass::getLatencyFor (decimation); }
+
+    /** Selects how many combs each comb switch runs. The lines are cleared
+        when the tier changes. */
+    void setCombTier (const CombTier newTier) {
+        if (newTier == combTier)
+            return;
+
+        auto settings = getNetworkSettings();
+        settings.combTier = newTier;
+        setNetwork (settings, hostSampleRate);
     }
 
+    CombTier getCombTier() const noexcept { return combTier; }
+
+    /** Selects how the delay lines are stored. bfloat16 halves the delay
+        memory, int16 the comb lines only, which mostly pays off where the
+        lines no longer fit in cache: several instances, high sample rates or
+        small cores. The lines are cleared when the format changes. */
+    void setDelayFormat (const DelayFormat newFormat) {
+        if (newFormat == delayFormat)
+            return;
+
+        auto settings = getNetworkSettings();
+        settings.delayFormat = newFormat;
+        setNetwork (settings, hostSampleRate);
+    }
+
+    DelayFormat getDelayFormat() const noexcept { return delayFormat; }
+
+    /** Returns the size of the memory block holding all the delay lines. */
+    size_t getDelayMemorySize() const noexcept { return delayMemory.getSizeInBytes(); }
+
+    /** Selects which build of the kernels to run, usually kernels::getPreferredIsa().
+        Falls back to the baseline build if the one asked for isn't available. */
+    void setKernels (const kernels::Isa isa) noexcept {
+        const kernels::Dispatch* selected = kernels::getDispatch (isa);
+        jassert (selected != nullptr);
+        dispatch = selected != nullptr ? kernels::Dispatcher (*selected) : kernels::Dispatcher();
+        combs.setDispatcher (dispatch);
+    }
+
+    kernels::Isa getKernels() const noexcept { return dispatch.getIsa(); }
+
     /** Clears the reverb's buffers. */
     void reset() {
-        for (int j = 0; j < numChannels; ++j) {
-            for (int i = 0; i < numCombs; ++i)
-                comb[j][i].clear();
+        clearNetwork();
 
-            for (int i = 0; i < numAllPasses; ++i)
-                allPass[j][i].clear();
-        }
-    }
+        for (int ch = 0; ch < numChannels; ++ch)
+            dryDelays[ch].reset();
 
-    void processStereo (float* const left, float* const right, const int numSamples) noexcept
-    {
-        jassert (left != nullptr && right != nullptr);
+        idle = false;
+        numQuietSamples = 0;
+    }
 
-        for (int i = 0; i < numSamples; ++i)
-        {
-            const float input = (left[i] + right[i]) * gain;
-            float outL = 0, outR = 0;
-
-            const float damp    = damping.getNextValue();
-            const float feedbck = feedback.getNextValue();
-
-            for (int j = 0; j < numCombs; ++j)  // accumulate the comb filters in parallel
-            {
-                if (! enabledCombs [j])
-                    continue;
-                outL += comb[0][j].process (input, damp, feedbck);
-                outR += comb[1][j].process (input, damp, feedbck);
-            }
+    /** Returns true if the last block skipped the filters, see updateIdle(). */
+    bool isIdle() const noexcept { return idle; }
 
-            for (int j = 0; j < numAllPasses; ++j)  // run the allpass filters in series
-            {
-                if ( ! enabledAllPasses [j])
-                    continue;
-                outL = allPass[0][j].process (outL);
-                outR = allPass[1][j].process (outR);
-            }
+    /** Applies the reverb to two stereo channels of audio data.
 
-            const float dry  = dryGain.getNextValue();
-            const float wet1 = wetGain1.getNextValue();
-            const float wet2 = wetGain2.getNextValue();
+        Works on float or double buffers. Delay lines are stored in the delay
+        format either way; the double path raises the precision of the
+        arithmetic, the combs' damping state and the smoothed coefficients.
+        The filter fades and the resampler stay in float. Call with denormals flushed to zero (juce::ScopedNoDenormals),
+        or decaying tails will run slowly.
+    */
+    template <typename SampleType>
+    void processStereo (SampleType* const left, SampleType* const right, const int numSamples) noexcept
+    {
+        jassert (left != nullptr && right != nullptr);
 
-            left[i]  = outL * wet1 + outR * wet2 + left[i]  * dry;
-            right[i] = outR * wet1 + outL * wet2 + right[i] * dry;
+        for (int offset = 0; offset < numSamples; offset += blockSize) {
+            const int numBlock = juce::jmin ((int) blockSize, numSamples - offset);
+            const bool inputSilent = isSilent (left + offset, numBlock) && isSilent (right + offset, numBlock);
+            if (updateIdle (inputSilent, numBlock, true))
+                processStereoIdle (left + offset, right + offset, numBlock);
+            else if (decimation > 1)
+                processStereoDecimated (left + offset, right + offset, numBlock);
+            else
+                processStereoBlock (left + offset, right + offset, numBlock, true);
         }
     }
 
     /** Applies the reverb to a single mono channel of audio data. */
-    void processMono (float* const samples, const int numSamples) noexcept
+    template <typename SampleType>
+    void processMono (SampleType* const samples, const int numSamples) noexcept
     {
         jassert (samples != nullptr);
 
+        for (int offset = 0; offset < numSamples; offset += blockSize) {
+            const int numBlock = juce::jmin ((int) blockSize, numSamples - offset);
+            if (updateIdle (isSilent (samples + offset, numBlock), numBlock, false))
+                processMonoIdle (samples + offset, numBlock);
+            else if (decimation > 1)
+                processMonoDecimated (samples + offset, numBlock);
+            else
+                processMonoBlock (samples + offset, numBlock, true);
+        }
+    }
+
+private:
+    static bool isFrozen (const float freezeMode) noexcept { return freezeMode >= 0.5f; }
+
+    void clearNetwork() noexcept {
+        combs.clear();
+
+        for (int j = 0; j < numChannels; ++j)
+            for (int i = 0; i < numAllPasses; ++i)
+                allPass[j][i].clear();
+
+        for (int ch = 0; ch < numChannels; ++ch) {
+            decimators[ch].reset();
+            interpolators[ch].reset();
+        }
+    }
+
+    //==============================================================================
+    template <typename SampleType>
+    static bool isSilent (const SampleType* samples, const int numSamples) noexcept {
         for (int i = 0; i < numSamples; ++i)
-        {
-            const float input = samples[i] * gain;
-            float output = 0;
-
-            const float damp    = damping.getNextValue();
-            const float feedbck = feedback.getNextValue();
-
-            for (int j = 0; j < numCombs; ++j)
-            {
-                // accumulate the comb filters in parallel
-                if (! enabledCombs [j])
-                    continue;
-                output += comb[0][j].process (input, damp, feedbck);
-            }
+            if (std::abs (samples[i]) > (SampleType) silenceThreshold)
+                return false;
+        return true;
+    }
+
+    /** Decides whether a block can skip the filters and pass the dry signal
+        through alone. That's the case once nothing has reached the combs for
+        long enough for every line to have played out and the lines have
+        decayed below silenceThreshold, or straight away while the wet level
+        is off. Anything ramping or fading runs the filters, as does input
+        arriving, so a block resumes from lines that are silent or cleared and
+        there's nothing to click. The lines are only scanned once per
+        tailCheckSamples of quiet. */
+    bool updateIdle (const bool inputSilent, const int numSamples, const bool stereo) noexcept {
+        const auto lanes = stereo ? CombBank::stereoLanes : CombBank::monoLanes;
+        const bool quiet = inputSilent || gain <= 0.0f || ! combs.hasActiveLanes (lanes);
+        numQuietSamples = quiet ? numQuietSamples + numSamples : 0;
+
+        if (! isSteady (stereo, false) || (! quiet && ! isWetOff (stereo))) {
+            idle = false;
+            return false;
+        }
+
+        if (! idle && (isWetOff (stereo) || (numQuietSamples >= tailCheckSamples && getTailPeak() < silenceThreshold))) {
+            // whatever is left is inaudible, and clearing it means a tail
+            // starts from nothing if the wet level comes back up
+            clearNetwork();
+            idle = true;
+        } else if (! idle && numQuietSamples >= tailCheckSamples) {
+            numQuietSamples = 0;
+        }
 
-            for (int j = 0; j < numAllPasses; ++j)
-            {
-                // run the allpass filters in series
-                if ( ! enabledAllPasses [j])
-                    continue;
-                output = allPass[0][j].process (output);
+        return idle;
+    }
+
+    /** With the wet gains at zero the filters can't be heard. Frozen lines are
+        kept running though, for when the wet level comes back. */
+    bool isWetOff (const bool stereo) const noexcept {
+        return ! isFrozen (parameters.freezeMode) && juce::exactlyEqual (wetGain1.getTargetValue(), 0.0)
+               && (! stereo || juce::exactlyEqual (wetGain2.getTargetValue(), 0.0));
+    }
+
+    /** Returns the loudest sample in any line that's running. */
+    float getTailPeak() const noexcept {
+        float peak = combs.getPeak (CombBank::stereoLanes);
+        for (int i = 0; i < numAllPasses; ++i)
+            if ((allPassMasks[CombBank::stereoLanes] & (1 << i)) != 0)
+                for (int ch = 0; ch < numChannels; ++ch)
+                    peak = juce::jmax (peak, allPass[ch][i].getLine().getPeak());
+        return peak;
+    }
+
+    /** Passes the dry signal through alone, delayed as the filters would have. */
+    template <typename SampleType>
+    void processStereoIdle (SampleType* const left, SampleType* const right, const int numSamples) noexcept {
+        auto& block = getBlockBuffers (left);
+        dryGain.render (block.dry, numSamples);
+
+        if (decimation > 1) {
+            for (int i = 0; i < numSamples; ++i) {
+                left[i] = dryDelays[0].process (left[i]) * block.dry[i];
+                right[i] = dryDelays[1].process (right[i]) * block.dry[i];
+            }
+        } else {
+            for (int i = 0; i < numSamples; ++i) {
+                left[i] *= block.dry[i];
+                right[i] *= block.dry[i];
             }
+        }
+    }
 
-            const float dry  = dryGain.getNextValue();
-            const float wet1 = wetGain1.getNextValue();
+    template <typename SampleType>
+    void processMonoIdle (SampleType* const samples, const int numSamples) noexcept {
+        auto& block = getBlockBuffers (samples);
+        dryGain.render (block.dry, numSamples);
+
+        if (decimation > 1) {
+            for (int i = 0; i < numSamples; ++i)
+                samples[i] = dryDelays[0].process (samples[i]) * block.dry[i];
+        } else {
+            for (int i = 0; i < numSamples; ++i)
+                samples[i] *= block.dry[i];
+        }
+    }
+
+    /** Fills delays and formats with the lengths and storage of the lines the
+        settings use, in the order they're laid out in the arena, and returns
+        how many there are. The allpass lines carry the sum of every comb, which
+        would clip int16's fixed full scale, so they stay in float then. */
+    static int getLinesInUse (const DelayLayout& layout, const NetworkSettings& settings,
+                              int* delays, DelayFormat* formats) noexcept {
+        const int numTierCombs = numCombs * getCombsPerSwitch (settings.combTier);
+        const DelayFormat allPassFormat = settings.delayFormat == DelayFormat::int16 ? DelayFormat::float32
+                                                                                    : settings.delayFormat;
+        int numLines = 0;
+        size_t index = 0;
+
+        for (int ch = 0; ch < numChannels; ++ch) {
+            for (int i = 0; i < maxCombs; ++i, ++index) {
+                if (i < numTierCombs) {
+                    formats[numLines] = settings.delayFormat;
+                    delays[numLines++] = layout.delays[index];
+                }
+            }
+        }
 
-            samples[i] = output * wet1 + samples[i] * dry;
+        for (int i = 0; i < numAllPasses; ++i) {
+            for (int ch = 0; ch < numChannels; ++ch, ++index) {
+                formats[numLines] = allPassFormat;
+                delays[numLines++] = layout.delays[index];
+            }
         }
+
+        return numLines;
     }
 
-private:
-    static bool isFrozen (const float freezeMode) noexcept { return freezeMode >= 0.5f; }
+    /** Points the lines at the arena swapped in, in the order getLinesInUse()
+        laid it out, and resets everything that depends on the rate. */
+    void installNetwork() noexcept {
+        const int numTierCombs = numCombs * getCombsPerSwitch (combTier);
+        DelayLine* lines[numDelayLines];
+        int delays[numDelayLines];
+        DelayFormat formats[numDelayLines];
+        const int numLines = getLinesInUse (delayLayout, getNetworkSettings(), delays, formats);
+        int lineIndex = 0;
+
+        for (int ch = 0; ch < numChannels; ++ch) {
+            for (int i = 0; i < maxCombs; ++i) {
+                DelayLine& line = combs.getLine (CombBank::laneFor (ch, i));
+                if (i < numTierCombs)
+                    lines[lineIndex++] = &line;
+                else
+                    line.resetStorage();
+            }
+        }
+
+        for (int i = 0; i < numAllPasses; ++i)
+            for (int ch = 0; ch < numChannels; ++ch)
+                lines[lineIndex++] = &allPass[ch][i].getLine();
+
+        jassert (lineIndex == numLines);
+
+        // after this long without input everything left in the lines has
+        // been played out at least once
+        int longestDelay = 0;
+        for (int i = 0; i < numLines; ++i) {
+            lines[i]->setStorage (delayMemory.getLine (i), formats[i], delays[i]);
+            longestDelay = juce::jmax (longestDelay, delays[i]);
+        }
+        tailCheckSamples = longestDelay * decimation + getLatencySamples();
+
+        combs.setNumCombs (numTierCombs);
+
+        // the dry signal is mixed in at the host rate, everything else is wet
+        const double internalRate = getInternalSampleRate();
+        const double smoothTime = 0.01;
+        damping.reset (internalRate, smoothTime);
+        feedback.reset (internalRate, smoothTime);
+        dryGain.reset (hostSampleRate, smoothTime);
+        wetGain1.reset (internalRate, smoothTime);
+        wetGain2.reset (internalRate, smoothTime);
+
+        reset();
+    }
 
     void updateDamping() noexcept {
-        const float roomScaleFactor = 0.28f;
-        const float roomOffset = 0.7f;
-        const float dampScaleFactor = 0.4f;
+        const double dampScaleFactor = 0.4;
 
         if (isFrozen (parameters.freezeMode))
-            setDamping (0.0f, 1.0f);
+            setDamping (0.0, 1.0);
         else
             setDamping (parameters.damping * dampScaleFactor,
                         parameters.roomSize * roomScaleFactor + roomOffset);
     }
 
-    void setDamping (const float dampingToUse, const float roomSizeToUse) noexcept {
+    void setDamping (const double dampingToUse, const double roomSizeToUse) noexcept {
         damping.setValue (dampingToUse);
         feedback.setValue (roomSizeToUse);
     }
 
-    class CombFilter {
-    public:
-        CombFilter() noexcept : bufferSize (0), bufferIndex (0), last (0), 
-                               targetGain(1.0f), currentGain(0.0f), 
-                               fadeSamplesRemaining(0), totalFadeSamples(0) {}
-
-        void setSize (const int size) {
-            if ((size_t) size != bufferSize) {
-                bufferIndex = 0;
-                bufferSize = (size_t) size;
-                buffer.reset (new float[bufferSize]);
+    /** Block processing is done filter by filter: the smoothed coefficients are
+        rendered up front, the combs fill an accumulator, then the allpass stages
+        run over it with both channels paired in one pass. The wet/dry/width
+        matrix is folded into the last enabled stage.
+
+        Most blocks have nothing moving at all, and those skip the rendering:
+        the coefficients and filter gains are passed as block constants.
+
+        Without withDry the output is the wet signal alone, and dryGain is
+        left for the caller to apply. */
+    template <typename SampleType>
+    void processStereoBlock (SampleType* const left, SampleType* const right, const int numSamples,
+                             const bool withDry) noexcept {
+        auto& block = getBlockBuffers (left);
+
+        for (int i = 0; i < numSamples; ++i)
+            block.input[i] = (left[i] + right[i]) * (SampleType) gain;
+
+        if (isSteady (true, withDry)) {
+            using Coeff = kernels::Constant<SampleType>;
+            const kernels::StereoMix<SampleType, Coeff> mix { left, right,
+                                                              { withDry ? (SampleType) dryGain.getTargetValue() : SampleType() },
+                                                              { (SampleType) wetGain1.getTargetValue() },
+                                                              { (SampleType) wetGain2.getTargetValue() } };
+            processStereoWet (block.input, Coeff { (SampleType) damping.getTargetValue() },
+                              Coeff { (SampleType) feedback.getTargetValue() },
+                              mix, block.outL, block.outR, numSamples);
+            return;
+        }
+
+        damping.render (block.damping, numSamples);
+        feedback.render (block.feedback, numSamples);
+        renderDry (block.dry, numSamples, withDry);
+        wetGain1.render (block.wet1, numSamples);
+        wetGain2.render (block.wet2, numSamples);
+
+        const kernels::StereoMix<SampleType> mix { left, right, block.dry, block.wet1, block.wet2 };
+        processStereoWet (block.input, (const SampleType*) block.damping, (const SampleType*) block.feedback,
+                          mix, block.outL, block.outR, numSamples);
+    }
+
+    template <typename SampleType>
+    void processMonoBlock (SampleType* const samples, const int numSamples, const bool withDry) noexcept {
+        auto& block = getBlockBuffers (samples);
+
+        for (int i = 0; i < numSamples; ++i)
+            block.input[i] = samples[i] * (SampleType) gain;
+
+        if (isSteady (false, withDry)) {
+            using Coeff = kernels::Constant<SampleType>;
+            const kernels::MonoMix<SampleType, Coeff> mix { samples,
+                                                            { withDry ? (SampleType) dryGain.getTargetValue() : SampleType() },
+                                                            { (SampleType) wetGain1.getTargetValue() } };
+            processMonoWet (block.input, Coeff { (SampleType) damping.getTargetValue() },
+                            Coeff { (SampleType) feedback.getTargetValue() },
+                            mix, block.outL, block.outR, numSamples);
+            return;
+        }
+
+        damping.render (block.damping, numSamples);
+        feedback.render (block.feedback, numSamples);
+        renderDry (block.dry, numSamples, withDry);
+        wetGain1.render (block.wet1, numSamples);
+
+        const kernels::MonoMix<SampleType> mix { samples, block.dry, block.wet1 };
+        processMonoWet (block.input, (const SampleType*) block.damping, (const SampleType*) block.feedback,
+                        mix, block.outL, block.outR, numSamples);
+    }
+
+    template <typename SampleType>
+    void renderDry (SampleType* const dest, const int numSamples, const bool withDry) noexcept {
+        if (withDry)
+            dryGain.render (dest, numSamples);
+        else
+            for (int i = 0; i < numSamples; ++i)
+                dest[i] = SampleType();
+    }
+
+    /** Runs the wet path of a block at the internal rate. The block is
+        decimated, rendered wet only, brought back up and then mixed with the
+        dry signal, delayed to match. */
+    template <typename SampleType>
+    void processStereoDecimated (SampleType* const left, SampleType* const right, const int numSamples) noexcept {
+        auto& block = getBlockBuffers (left);
+
+        const int numLow = decimators[0].process (left, block.lowL, numSamples);
+        decimators[1].process (right, block.lowR, numSamples);
+
+        if (numLow > 0)
+            processStereoBlock (block.lowL, block.lowR, numLow, false);
+
+        interpolators[0].process (block.lowL, block.outL, numSamples);
+        interpolators[1].process (block.lowR, block.outR, numSamples);
+        dryGain.render (block.dry, numSamples);
+
+        for (int i = 0; i < numSamples; ++i) {
+            left[i] = dryDelays[0].process (left[i]) * block.dry[i] + block.outL[i];
+            right[i] = dryDelays[1].process (right[i]) * block.dry[i] + block.outR[i];
+        }
+    }
+
+    template <typename SampleType>
+    void processMonoDecimated (SampleType* const samples, const int numSamples) noexcept {
+        auto& block = getBlockBuffers (samples);
+
+        const int numLow = decimators[0].process (samples, block.lowL, numSamples);
+
+        if (numLow > 0)
+            processMonoBlock (block.lowL, numLow, false);
+
+        interpolators[0].process (block.lowL, block.outL, numSamples);
+        dryGain.render (block.dry, numSamples);
+
+        for (int i = 0; i < numSamples; ++i)
+            samples[i] = dryDelays[0].process (samples[i]) * block.dry[i] + block.outL[i];
+    }
+
+    /** Returns true when no smoother is ramping and no filter still running is fading.
+        Mono processing never advances wetGain2 or the right channel filters,
+        so those are left out of its check, as is dryGain when the dry signal
+        is mixed in elsewhere. */
+    bool isSteady (const bool stereo, const bool withDry) const noexcept {
+        if (damping.isSmoothing() || feedback.isSmoothing() || (withDry && dryGain.isSmoothing())
+            || wetGain1.isSmoothing() || (stereo && wetGain2.isSmoothing()))
+            return false;
+
+        const auto lanes = stereo ? CombBank::stereoLanes : CombBank::monoLanes;
+        if (combs.isFading (lanes))
+            return false;
+
+        for (int j = 0; j < numAllPasses; ++j)
+            if ((allPassMasks[lanes] & (1 << j)) != 0)
+                for (int ch = 0; ch < (stereo ? numChannels : 1); ++ch)
+                    if (allPass[ch][j].isFading())
+                        return false;
+
+        return true;
+    }
+
+    /** Frozen and steady, the combs have no input, no damping and unity
+        feedback, so they can be looped instead of recirculated. Anything
+        still moving goes through the full kernels. */
+    template <typename SampleType>
+    bool isLooping (const SampleType*) const noexcept { return false; }
+
+    template <typename SampleType>
+    bool isLooping (kernels::Constant<SampleType>) const noexcept { return isFrozen (parameters.freezeMode); }
+
+    template <typename SampleType, typename Coeffs>
+    void processStereoWet (const SampleType* input, Coeffs damp, Coeffs feedbackLevel,
+                           const kernels::StereoMix<SampleType, Coeffs>& mix,
+                           SampleType* const outL, SampleType* const outR, const int numSamples) noexcept {
+        // accumulate the comb filters in parallel
+        if (isLooping (damp))
+            combs.processLoop (CombBank::stereoLanes, outL, outR, numSamples);
+        else
+            combs.process (input, damp, feedbackLevel, CombBank::stereoLanes, outL, outR, numSamples);
+
+        static constexpr auto chains = makeChainTable<StereoChain<SampleType, Coeffs>> (
+            [] (auto stages) { return &SyncRoboVerb::processStereoChain<decltype (stages)::value, SampleType, Coeffs>; });
+        (this->*chains[(size_t) allPassMasks[CombBank::stereoLanes]]) (outL, outR, mix, numSamples);
+        retireSilentStages (CombBank::stereoLanes);
+    }
+
+    template <typename SampleType, typename Coeffs>
+    void processMonoWet (const SampleType* input, Coeffs damp, Coeffs feedbackLevel,
+                         const kernels::MonoMix<SampleType, Coeffs>& mix,
+                         SampleType* const output, SampleType* const unused, const int numSamples) noexcept {
+        // accumulate the comb filters in parallel, left lines only
+        if (isLooping (damp))
+            combs.processLoop (CombBank::monoLanes, output, unused, numSamples);
+        else
+            combs.process (input, damp, feedbackLevel, CombBank::monoLanes, output, unused, numSamples);
+
+        static constexpr auto chains = makeChainTable<MonoChain<SampleType, Coeffs>> (
+            [] (auto stages) { return &SyncRoboVerb::processMonoChain<decltype (stages)::value, SampleType, Coeffs>; });
+        (this->*chains[(size_t) allPassMasks[CombBank::monoLanes]]) (output, mix, numSamples);
+        retireSilentStages (CombBank::monoLanes);
+    }
+
+    //==============================================================================
+    /** The allpass chain is instantiated once per set of running stages, with
+        the stages unrolled and the output matrix fused into the last one. The
+        instantiation is picked from a table by allPassMasks once per block, as
+        the set only changes between blocks. */
+    template <typename SampleType, typename Coeffs>
+    using StereoChain = void (SyncRoboVerb::*) (SampleType*, SampleType*, const kernels::StereoMix<SampleType, Coeffs>&, int);
+
+    template <typename SampleType, typename Coeffs>
+    using MonoChain = void (SyncRoboVerb::*) (SampleType*, const kernels::MonoMix<SampleType, Coeffs>&, int);
+
+    enum { numAllPassSets = 1 << numAllPasses };
+
+    template <typename Chain, typename Factory, int... stageMasks>
+    static constexpr std::array<Chain, numAllPassSets> makeChainTable (Factory factory, std::integer_sequence<int, stageMasks...>) {
+        return { { factory (std::integral_constant<int, stageMasks>())... } };
+    }
+
+    template <typename Chain, typename Factory>
+    static constexpr std::array<Chain, numAllPassSets> makeChainTable (Factory factory) {
+        return makeChainTable<Chain> (factory, std::make_integer_sequence<int, numAllPassSets>());
+    }
+
+    /** Returns the last stage in a mask, or -1 if it's empty. */
+    static constexpr int lastStageIn (const int stageMask) noexcept {
+        return stageMask == 0 ? -1 : 1 + lastStageIn (stageMask >> 1);
+    }
+
+    /** Calls function for each stage in the mask, in order. */
+    template <int stageMask, typename Function>
+    static void forEachStage (Function&& function) noexcept {
+        static_assert (numAllPasses == 4, "forEachStage() is unrolled for four stages");
+        if constexpr ((stageMask & 1) != 0)
+            function (0);
+        if constexpr ((stageMask & 2) != 0)
+            function (1);
+        if constexpr ((stageMask & 4) != 0)
+            function (2);
+        if constexpr ((stageMask & 8) != 0)
+            function (3);
+    }
+
+    template <int stageMask, typename SampleType, typename Coeffs>
+    void processStereoChain (SampleType* const outL, SampleType* const outR,
+                             const kernels::StereoMix<SampleType, Coeffs>& mix, const int numSamples) noexcept {
+        constexpr int lastStage = lastStageIn (stageMask);
+
+        if constexpr (lastStage < 0) {
+            dispatch.stereoMix (outL, outR, mix, numSamples);
+        } else {
+            // run the allpass filters in series
+            forEachStage<stageMask> ([&] (const int j) {
+                processAllPassPair (j, outL, outR, numSamples, j == lastStage ? &mix : nullptr);
+            });
+        }
+    }
+
+    template <int stageMask, typename SampleType, typename Coeffs>
+    void processMonoChain (SampleType* const output, const kernels::MonoMix<SampleType, Coeffs>& mix,
+                           const int numSamples) noexcept {
+        constexpr int lastStage = lastStageIn (stageMask);
+
+        if constexpr (lastStage < 0) {
+            dispatch.monoMix (output, mix, numSamples);
+        } else {
+            // run the allpass filters in series
+            forEachStage<stageMask> ([&] (const int j) {
+                processAllPassMono (j, output, numSamples, j == lastStage ? &mix : nullptr);
+            });
+        }
+    }
+
+    /** A stage runs while it's switched on, still fading out or warming up,
+        for each lane set: mono processing only ever runs the left stages. */
+    void updateAllPassMasks() noexcept {
+        allPassMasks[CombBank::stereoLanes] = allPassMasks[CombBank::monoLanes] = 0;
+        for (int i = 0; i < numAllPasses; ++i) {
+            if (! allPass[0][i].isIdle())
+                allPassMasks[CombBank::monoLanes] |= 1 << i;
+            if (! allPass[0][i].isIdle() || ! allPass[1][i].isIdle())
+                allPassMasks[CombBank::stereoLanes] |= 1 << i;
+        }
+    }
+
+    /** Drops stages whose fade out finished in the last block from the chain. */
+    void retireSilentStages (const int lanes) noexcept {
+        for (int i = 0; i < numAllPasses; ++i) {
+            if ((allPassMasks[lanes] & (1 << i)) != 0 && allPass[0][i].isIdle()
+                && (lanes == CombBank::monoLanes || allPass[1][i].isIdle())) {
+                updateAllPassMasks();
+                return;
             }
+        }
+    }
+
+    template <typename SampleType>
+    void processAllPassPair (const int stage, SampleType* const wetL, SampleType* const wetR, const int numSamples,
+                             const kernels::StereoMix<SampleType>* mix) noexcept {
+        alignas (64) SampleType gainsL[blockSize];
+        alignas (64) SampleType gainsR[blockSize];
+        allPass[0][stage].renderGains (gainsL, numSamples);
+        allPass[1][stage].renderGains (gainsR, numSamples);
+        runAllPassPair (stage, wetL, wetR, numSamples, (const SampleType*) gainsL, (const SampleType*) gainsR, mix);
+    }
+
+    template <typename SampleType>
+    void processAllPassPair (const int stage, SampleType* const wetL, SampleType* const wetR, const int numSamples,
+                             const kernels::StereoMix<SampleType, kernels::Constant<SampleType>>* mix) noexcept {
+        const kernels::Constant<SampleType> gainL { (SampleType) allPass[0][stage].settleGain() };
+        const kernels::Constant<SampleType> gainR { (SampleType) allPass[1][stage].settleGain() };
+        runAllPassPair (stage, wetL, wetR, numSamples, gainL, gainR, mix);
+    }
+
+    template <typename SampleType>
+    void processAllPassMono (const int stage, SampleType* const wet, const int numSamples,
+                             const kernels::MonoMix<SampleType>* mix) noexcept {
+        alignas (64) SampleType gains[blockSize];
+        allPass[0][stage].renderGains (gains, numSamples);
+        runAllPassMono (stage, wet, numSamples, (const SampleType*) gains, mix);
+    }
+
+    template <typename SampleType>
+    void processAllPassMono (const int stage, SampleType* const wet, const int numSamples,
+                             const kernels::MonoMix<SampleType, kernels::Constant<SampleType>>* mix) noexcept {
+        const kernels::Constant<SampleType> gains { (SampleType) allPass[0][stage].settleGain() };
+        runAllPassMono (stage, wet, numSamples, gains, mix);
+    }
+
+    /** Runs both channels of an allpass stage, in chunks no longer than either delay. */
+    template <typename SampleType, typename Gains, typename Coeffs>
+    void runAllPassPair (const int stage, SampleType* const wetL, SampleType* const wetR, const int numSamples,
+                         Gains gainsL, Gains gainsR, const kernels::StereoMix<SampleType, Coeffs>* mix) noexcept {
+        DelayLine& lineL = allPass[0][stage].getLine();
+        DelayLine& lineR = allPass[1][stage].getLine();
+
+        visitStorage (lineL.getFormat(), [&] (auto* stored) {
+            using Stored = std::remove_pointer_t<decltype (stored)>;
 
-            clear();
+            for (int i = 0; i < numSamples;) {
+                const int limit = juce::jmin (numSamples - i, lineL.getDelay(), lineR.getDelay());
+                const int numChunk = juce::jmin (lineL.getNumContiguous (limit), lineR.getNumContiguous (limit));
+
+                if (mix != nullptr)
+                    dispatch.allPassPairMixChunk (lineL.getReadPointer<Stored>(), lineL.getWritePointer<Stored>(),
+                                                  lineR.getReadPointer<Stored>(), lineR.getWritePointer<Stored>(),
+                                                  wetL + i, wetR + i, gainsL + i, gainsR + i, mix->at (i), numChunk);
+                else
+                    dispatch.allPassPairChunk (lineL.getReadPointer<Stored>(), lineL.getWritePointer<Stored>(),
+                                               lineR.getReadPointer<Stored>(), lineR.getWritePointer<Stored>(),
+                                               wetL + i, wetR + i, gainsL + i, gainsR + i, numChunk);
+
+                lineL.advance (numChunk);
+                lineR.advance (numChunk);
+                i += numChunk;
+            }
+        });
+    }
+
+    template <typename SampleType, typename Gains, typename Coeffs>
+    void runAllPassMono (const int stage, SampleType* const wet, const int numSamples,
+                         Gains gains, const kernels::MonoMix<SampleType, Coeffs>* mix) noexcept {
+        DelayLine& line = allPass[0][stage].getLine();
+
+        visitStorage (line.getFormat(), [&] (auto* stored) {
+            using Stored = std::remove_pointer_t<decltype (stored)>;
+
+            for (int i = 0; i < numSamples;) {
+                const int numChunk = line.getNumContiguous (juce::jmin (numSamples - i, line.getDelay()));
+
+                if (mix != nullptr)
+                    dispatch.allPassMixChunk (line.getReadPointer<Stored>(), line.getWritePointer<Stored>(),
+                                              wet + i, gains + i, mix->at (i), numChunk);
+                else
+                    dispatch.allPassChunk (line.getReadPointer<Stored>(), line.getWritePointer<Stored>(),
+                                           wet + i, gains + i, numChunk);
+
+                line.advance (numChunk);
+                i += numChunk;
+            }
+        });
+    }
+
+    /** The parallel comb filters of both channels, stored as struct-of-arrays.
+
+        Lane k holds comb (k % maxCombs) of channel (k / maxCombs), of which
+        the first getNumCombs() of each channel are in use. Blocks are rendered
+        one lane at a time over a compacted list of the active lanes, with the
+        time-axis kernels from kernels.hpp, which vectorize along the samples
+        for whichever instruction set was dispatched.
+
+        A lane is active while it's switched on or still fading out, and is
+        only retired once its fade has reached zero, so switching a comb off
+        is as smooth as switching it on. A lane can also be warmed: run at
+        zero gain ahead of being switched on, to build up its tail. A switched
+        off comb costs nothing once retired, and keeps its delay line and
+        damping state exactly as they were.
+    */
+    class CombBank {
+    public:
+        enum { numLanes = numChannels * maxCombs };
+
+        /** Which lanes a call to process() should run. */
+        enum LaneSet { stereoLanes = 0, monoLanes };
+
+        CombBank() noexcept {
+            for (int k = 0; k < numLanes; ++k)
+                last[k] = 0.0;
+
+            numActiveLanes[0] = numActiveLanes[1] = 0;
+
+            for (int k = 0; k < numLanes; ++k)
+                warming[k] = false;
+        }
+
+        static constexpr int laneFor (const int channel, const int combIndex) noexcept {
+            return channel * maxCombs + combIndex;
+        }
+
+        /** Sets how many combs per channel are in use. Lanes past those have
+            no storage and are never run. */
+        void setNumCombs (const int newNumCombs) noexcept {
+            jassert (newNumCombs == numCombs || newNumCombs == numCombs * 2 || newNumCombs == maxCombs);
+            numCombsInUse = newNumCombs;
+            updateActiveLanes();
         }
 
+        int getNumCombs() const noexcept { return numCombsInUse; }
+
+        DelayLine& getLine (const int lane) noexcept { return lines[lane]; }
+
+        void setDispatcher (const kernels::Dispatcher& newDispatch) noexcept { dispatch = newDispatch; }
+
         void clear() noexcept {
-            last = 0;
-            memset (buffer.get(), 0, sizeof (float) * (size_t) bufferSize);
+            for (int k = 0; k < numLanes; ++k)
+                clear (k);
         }
-        
-        void startFade(bool enabled, int fadeDurationSamples) noexcept {
-            targetGain = enabled ? 1.0f : 0.0f;
-            totalFadeSamples = fadeDurationSamples;
-            fadeSamplesRemaining = fadeDurationSamples;
-        }
-
-        float process (const float input, const float damp, const float feedbackLevel) noexcept {
-            // Update crossfade if active
-            if (fadeSamplesRemaining > 0) {
-                float progress = 1.0f - (float(fadeSamplesRemaining) / totalFadeSamples);
-                currentGain = currentGain + (targetGain - currentGain) * progress;
-                fadeSamplesRemaining--;
-            } else {
-                currentGain = targetGain;
+
+        void clear (const int lane) noexcept {
+            last[lane] = 0.0;
+            lines[lane].clear();
+        }
+
+        /** Starts a fade on both channels of every comb of a switch, in use or
+            not, so a change of tier finds them all where the switch is. Call
+            updateActiveLanes() once the fades for a change of switches have
+            been started. */
+        void startFade (const int switchIndex, bool enabled, int fadeDurationSamples, const FadeCurve curve) noexcept {
+            for (int i = switchIndex; i < maxCombs; i += numCombs)
+                for (int ch = 0; ch < numChannels; ++ch)
+                    fades[laneFor (ch, i)].start (enabled ? 1.0f : 0.0f, fadeDurationSamples, curve);
+        }
+
+        /** Starts or stops warming both channels of every comb of a switch. A
+            line that starts warming from silence is cleared first. Call
+            updateActiveLanes() after. */
+        void setWarming (const int switchIndex, const bool shouldWarm) noexcept {
+            for (int i = switchIndex; i < maxCombs; i += numCombs) {
+                for (int ch = 0; ch < numChannels; ++ch) {
+                    const int k = laneFor (ch, i);
+                    if (shouldWarm && ! warming[k] && fades[k].isSilent())
+                        clear (k);
+                    warming[k] = shouldWarm;
+                }
             }
-            
-            const float output = buffer[bufferIndex];
-            last = (output * (1.0f - damp)) + (last * damp);
-            JUCE_UNDENORMALISE (last);
+        }
+
+        /** Rebuilds the active lane lists from the lanes' fades. */
+        void updateActiveLanes() noexcept {
+            numActiveLanes[stereoLanes] = numActiveLanes[monoLanes] = 0;
+
+            for (int ch = 0; ch < numChannels; ++ch) {
+                for (int i = 0; i < numCombsInUse; ++i) {
+                    if (isIdle (laneFor (ch, i)))
+                        continue;
+
+                    const int k = laneFor (ch, i);
+                    activeLanes[stereoLanes][numActiveLanes[stereoLanes]++] = k;
+                    if (ch == 0)
+                        activeLanes[monoLanes][numActiveLanes[monoLanes]++] = k;
+                }
+            }
+        }
+
+        bool hasActiveLanes (const LaneSet lanes) const noexcept { return numActiveLanes[lanes] > 0; }
+
+        /** Returns the loudest sample held in any of the set's active lines. */
+        float getPeak (const LaneSet lanes) const noexcept {
+            float peak = 0.0f;
+            for (int a = 0; a < numActiveLanes[lanes]; ++a)
+                peak = juce::jmax (peak, lines[activeLanes[lanes][a]].getPeak());
+            return peak;
+        }
+
+        /** Returns true if any lane in the set is still crossfading. */
+        bool isFading (const LaneSet lanes) const noexcept {
+            for (int a = 0; a < numActiveLanes[lanes]; ++a)
+                if (fades[activeLanes[lanes][a]].isFading())
+                    return true;
+            return false;
+        }
+
+        /** Renders a block of every active lane, writing the per-channel sums to outL and outR. */
+        template <typename SampleType>
+        void process (const SampleType* input, const SampleType* damp, const SampleType* feedbackLevel,
+                      const LaneSet lanes, SampleType* outL, SampleType* outR, const int numSamples) noexcept {
+            endLoop();
+            processLines (input, damp, feedbackLevel, lanes, outL, outR, numSamples);
+            retireSilentLanes (lanes);
+        }
+
+        /** Nothing is fading in a steady block, so nothing can be retired. */
+        template <typename SampleType>
+        void process (const SampleType* input, const kernels::Constant<SampleType> damp,
+                      const kernels::Constant<SampleType> feedbackLevel,
+                      const LaneSet lanes, SampleType* outL, SampleType* outR, const int numSamples) noexcept {
+            endLoop();
+            processLines (input, damp, feedbackLevel, lanes, outL, outR, numSamples);
+        }
+
+        /** Plays every active lane back as a read-only loop, for freeze. The
+            lines are only touched again once a call to process() ends the loop. */
+        template <typename SampleType>
+        void processLoop (const LaneSet lanes, SampleType* outL, SampleType* outR, const int numSamples) noexcept {
+            for (int i = 0; i < numSamples; ++i)
+                outL[i] = outR[i] = 0.0f;
 
-            float temp = input + (last * feedbackLevel);
-            JUCE_UNDENORMALISE (temp);
-            buffer[bufferIndex] = temp;
-            bufferIndex = (bufferIndex + 1) % bufferSize;
-            return output * currentGain;
+            looping = true;
+
+            for (int a = 0; a < numActiveLanes[lanes]; ++a) {
+                const int k = activeLanes[lanes][a];
+                runLoop (k, kernels::Constant<SampleType> { (SampleType) fades[k].settle() },
+                         k < maxCombs ? outL : outR, numSamples);
+            }
         }
 
     private:
-        std::unique_ptr<float[]> buffer;
-        std::size_t bufferSize { 0 };
-        std::size_t bufferIndex { 0 };
-        float last;
-        
-        // Crossfade support
-        float targetGain;
-        float currentGain;
-        int fadeSamplesRemaining;
-        int totalFadeSamples;
+        /** Returns true if a lane is faded out and not warming, so needn't run. */
+        bool isIdle (const int lane) const noexcept { return fades[lane].isSilent() && ! warming[lane]; }
+
+        /** Drops lanes whose fade out finished in the last block from the lists. */
+        void retireSilentLanes (const LaneSet lanes) noexcept {
+            for (int a = 0; a < numActiveLanes[lanes]; ++a) {
+                if (isIdle (activeLanes[lanes][a])) {
+                    updateActiveLanes();
+                    return;
+                }
+            }
+        }
+
+        template <typename SampleType, typename Coeffs>
+        void processLines (const SampleType* input, Coeffs damp, Coeffs feedbackLevel,
+                           const LaneSet lanes, SampleType* outL, SampleType* outR, const int numSamples) noexcept {
+            for (int i = 0; i < numSamples; ++i)
+                outL[i] = outR[i] = 0.0f;
+
+            for (int a = 0; a < numActiveLanes[lanes]; ++a) {
+                const int k = activeLanes[lanes][a];
+                processLine (k, input, damp, feedbackLevel, k < maxCombs ? outL : outR, numSamples);
+            }
+        }
+
+        template <typename SampleType>
+        void processLine (const int k, const SampleType* input, const SampleType* damp, const SampleType* feedbackLevel,
+                          SampleType* accumulator, const int numSamples) noexcept {
+            alignas (64) SampleType gains[blockSize];
+            fades[k].render (gains, numSamples);
+            runLine (k, input, damp, feedbackLevel, (const SampleType*) gains, accumulator, numSamples);
+        }
+
+        /** With nothing moving the lane's fade is over, so its gain is a constant too. */
+        template <typename SampleType>
+        void processLine (const int k, const SampleType* input, kernels::Constant<SampleType> damp,
+                          kernels::Constant<SampleType> feedbackLevel, SampleType* accumulator, const int numSamples) noexcept {
+            runLine (k, input, damp, feedbackLevel, kernels::Constant<SampleType> { (SampleType) fades[k].settle() },
+                     accumulator, numSamples);
+        }
+
+        /** Runs a single lane over a block, adding its output to the accumulator.
+            The block is cut into chunks no longer than the line's delay, which the
+            time-axis kernel can vectorize along the samples. */
+        template <typename SampleType, typename Coeffs, typename Gains>
+        void runLine (const int k, const SampleType* input, Coeffs damp, Coeffs feedbackLevel, Gains gains,
+                      SampleType* accumulator, const int numSamples) noexcept {
+            DelayLine& line = lines[k];
+            SampleType state = (SampleType) last[k];
+
+            visitStorage (line.getFormat(), [&] (auto* stored) {
+                using Stored = std::remove_pointer_t<decltype (stored)>;
+
+                for (int i = 0; i < numSamples;) {
+                    const int numChunk = line.getNumContiguous (juce::jmin (numSamples - i, line.getDelay()));
+                    state = dispatch.combChunk (line.getReadPointer<Stored>(), line.getWritePointer<Stored>(), input + i,
+                                                damp + i, feedbackLevel + i, gains + i,
+                                                accumulator + i, numChunk, state);
+                    line.advance (numChunk);
+                    i += numChunk;
+                }
+            });
+
+            last[k] = state;
+        }
+
+        template <typename SampleType, typename Gains>
+        void runLoop (const int k, Gains gains, SampleType* accumulator, const int numSamples) noexcept {
+            DelayLine& line = lines[k];
+            SampleType state = (SampleType) last[k];
+
+            visitStorage (line.getFormat(), [&] (auto* stored) {
+                using Stored = std::remove_pointer_t<decltype (stored)>;
+
+                for (int i = 0; i < numSamples;) {
+                    const int numChunk = line.getNumContiguousInLoop (numSamples - i);
+                    state = dispatch.combLoopChunk (line.getReadPointer<Stored>(), gains + i, accumulator + i,
+                                                    numChunk, state);
+                    line.advanceLoop (numChunk);
+                    i += numChunk;
+                }
+            });
+
+            last[k] = state;
+        }
+
+        void endLoop() noexcept {
+            if (! looping)
+                return;
+
+            for (int k = 0; k < numLanes; ++k)
+                lines[k].endLoop();
+            looping = false;
+        }
+
+        kernels::Dispatcher dispatch;
+        DelayLine lines[numLanes];
+        alignas (64) double last[numLanes]; // double, so the double path keeps its precision across blocks
+        int activeLanes[2][numLanes];
+        int numActiveLanes[2];
+        bool looping { false };
+        int numCombsInUse { numCombs };
+        GainFade fades[numLanes];
+        bool warming[numLanes];
     };
 
     //==============================================================================
     class AllPassFilter {
     public:
-        AllPassFilter() noexcept : bufferSize (0), bufferIndex (0), 
-                                  targetGain(1.0f), currentGain(0.0f), 
-                                  fadeSamplesRemaining(0), totalFadeSamples(0) {}
-
-        void setSize (const int size) {
-            if ((size_t) size != bufferSize) {
-                bufferIndex = 0;
-                buffer.reset (new float[(size_t) size]);
-                bufferSize = (size_t) size;
-            }
+        AllPassFilter() noexcept = default;
 
-            clear();
-        }
+        DelayLine& getLine() noexcept { return line; }
+        const DelayLine& getLine() const noexcept { return line; }
 
         void clear() noexcept {
-            memset (buffer.get(), 0, sizeof (float) * (size_t) bufferSize);
+            line.clear();
         }
         
-        void startFade(bool enabled, int fadeDurationSamples) noexcept {
-            targetGain = enabled ? 1.0f : 0.0f;
-            totalFadeSamples = fadeDurationSamples;
-            fadeSamplesRemaining = fadeDurationSamples;
-        }
-
-        float process (const float input) noexcept {
-            // Update crossfade if active
-            if (fadeSamplesRemaining > 0) {
-                float progress = 1.0f - (float(fadeSamplesRemaining) / totalFadeSamples);
-                currentGain = currentGain + (targetGain - currentGain) * progress;
-                fadeSamplesRemaining--;
-            } else {
-                currentGain = targetGain;
-            }
-            
-            const float bufferedValue = buffer[bufferIndex];
-            float temp = input + (bufferedValue * 0.5f);
-            // JUCE_UNDENORMALISE (temp);
-            buffer[bufferIndex] = temp;
-            bufferIndex = (bufferIndex + 1) % bufferSize;
-            float output = bufferedValue - input;
-            return output * currentGain;
+        void startFade (bool enabled, int fadeDurationSamples, const FadeCurve curve) noexcept {
+            fade.start (enabled ? 1.0f : 0.0f, fadeDurationSamples, curve);
         }
 
+        /** Advances the crossfade over a block, writing the gain for each sample. */
+        template <typename SampleType>
+        void renderGains (SampleType* gains, const int numSamples) noexcept {
+            fade.render (gains, numSamples);
+        }
+
+        bool isFading() const noexcept { return fade.isFading(); }
+
+        /** Runs the stage bypassed while it's switched off, so its line is
+            primed for when it's switched on. */
+        void setWarming (const bool shouldWarm) noexcept {
+            if (shouldWarm && ! warming && fade.isSilent())
+                line.clear();
+            warming = shouldWarm;
+        }
+
+        /** Returns true once a fade out has finished and the stage isn't
+            warming, so it can be left out. */
+        bool isIdle() const noexcept { return fade.isSilent() && ! warming; }
+
+        /** Once the fade is over, returns the gain it settled on. */
+        float settleGain() const noexcept { return fade.settle(); }
+
     private:
-        std::unique_ptr<float[]> buffer;
-        std::size_t bufferSize, bufferIndex;
-        
-        // Crossfade support
-        float targetGain;
-        float currentGain;
-        int fadeSamplesRemaining;
-        int totalFadeSamples;
+        DelayLine line;
+        GainFade fade;
+        bool warming { false };
     };
 
+    template <typename ValueType>
     class LinearSmoothedValue {
     public:
         LinearSmoothedValue() noexcept
@@ -578,7 +1546,7 @@ private:
             countdown = 0;
         }
 
-        void setValue (float newValue) noexcept {
+        void setValue (ValueType newValue) noexcept {
             if (! juce::exactlyEqual (target, newValue)) {
                 target = newValue;
                 countdown = stepsToTarget;
@@ -586,11 +1554,14 @@ private:
                 if (countdown <= 0)
                     currentValue = target;
                 else
-                    step = (target - currentValue) / (float) countdown;
+                    step = (target - currentValue) / (ValueType) countdown;
             }
         }
 
-        float getNextValue() noexcept {
+        bool isSmoothing() const noexcept { return countdown > 0; }
+        ValueType getTargetValue() const noexcept { return target; }
+
+        ValueType getNextValue() noexcept {
             if (countdown <= 0)
                 return target;
 
@@ -599,23 +1570,72 @@ private:
             return currentValue;
         }
 
+        /** Writes the next numSamples values to dest, same as calling getNextValue() for each. */
+        template <typename SampleType>
+        void render (SampleType* dest, const int numSamples) noexcept {
+            int i = 0;
+            for (; i < numSamples && countdown > 0; ++i) {
+                --countdown;
+                currentValue += step;
+                dest[i] = (SampleType) currentValue;
+            }
+
+            for (; i < numSamples; ++i)
+                dest[i] = (SampleType) target;
+        }
+
     private:
-        float currentValue, target, step;
+        ValueType currentValue, target, step;
         int countdown, stepsToTarget;
     };
 
     //==============================================================================
 
-    bool enabledCombs[numCombs];
-    bool enabledAllPasses[numAllPasses];
+    juce::uint16 switches { 0 };
+    int allPassMasks[2] {};
 
     Parameters parameters;
     float gain;
 
-    CombFilter comb[numChannels][numCombs];
+    kernels::Dispatcher dispatch;
+    DelayFormat delayFormat { DelayFormat::float32 };
+    CombTier combTier { CombTier::standard };
+    DelayLayout delayLayout;
+    DelayArena delayMemory;
+    bool decimated { false };
+    int decimation { 1 };
+    double hostSampleRate { 44100.0 };
+    bool idle { false };
+    int numQuietSamples { 0 };
+    int tailCheckSamples { 0 };
+    PolyphaseDecimator decimators[numChannels];
+    PolyphaseInterpolator interpolators[numChannels];
+    CompensationDelay dryDelays[numChannels];
+    CombBank combs;
     AllPassFilter allPass[numChannels][numAllPasses];
 
-    LinearSmoothedValue damping, feedback, dryGain, wetGain1, wetGain2;
+    LinearSmoothedValue<double> damping, feedback, dryGain, wetGain1, wetGain2;
+
+    /** Per-block scratch for the rendered coefficients and wet signal. */
+    template <typename SampleType>
+    struct BlockBuffers {
+        alignas (64) SampleType input[blockSize];
+        alignas (64) SampleType damping[blockSize];
+        alignas (64) SampleType feedback[blockSize];
+        alignas (64) SampleType dry[blockSize];
+        alignas (64) SampleType wet1[blockSize];
+        alignas (64) SampleType wet2[blockSize];
+        alignas (64) SampleType outL[blockSize];
+        alignas (64) SampleType outR[blockSize];
+        alignas (64) SampleType lowL[blockSize];
+        alignas (64) SampleType lowR[blockSize];
+    };
+
+    BlockBuffers<float> floatBlock;
+    BlockBuffers<double> doubleBlock;
+
+    BlockBuffers<float>& getBlockBuffers (const float*) noexcept { return floatBlock; }
+    BlockBuffers<double>& getBlockBuffers (const double*) noexcept { return doubleBlock; }
     TempoSyncedRandomizer randomizer;
     TempoSyncedCrossfadeManager crossfadeManager;
 
@@ -626,25 +1646,52 @@ public:
     TempoSyncedCrossfadeManager& getCrossfadeManager() { return crossfadeManager; }
     const TempoSyncedCrossfadeManager& getCrossfadeManager() const { return crossfadeManager; }
     
-    void updateAllFilters(bool newCombStates[], bool newAllPassStates[]) {
-        int fadeSamples = crossfadeManager.calculateFadeSamples();
-        
+    /** Feeds filters that are switched off but about to be switched on, with
+        their output muted, so they come in with a tail built from the current
+        input instead of whatever they held when they were last on. A filter
+        stops warming when it's switched on, or when its bit is left out here. */
+    void warmFilters (const juce::uint16 switchesToWarm) noexcept {
+        const juce::uint16 warm = switchesToWarm & ~switches;
+
+        for (int i = 0; i < numCombs; ++i)
+            combs.setWarming (i, (warm & combBit (i)) != 0);
+        combs.updateActiveLanes();
+
+        for (int i = 0; i < numAllPasses; ++i)
+            for (int ch = 0; ch < numChannels; ++ch)
+                allPass[ch][i].setWarming ((warm & allPassBit (i)) != 0);
+        updateAllPassMasks();
+    }
+
+private:
+    /** Fades the filters whose switches changed in or out, found as the bits
+        that differ between the old and new masks. A filter switched off keeps
+        running until its fade out is over. */
+    void switchFilters (const juce::uint16 newSwitches, const int fadeSamples) noexcept {
+        const juce::uint16 changed = switches ^ newSwitches;
+        if (changed == 0)
+            return;
+
+        const FadeCurve fadeCurve = crossfadeManager.getFadeCurve();
+        switches = newSwitches;
+
         for (int i = 0; i < numCombs; ++i) {
-            if (enabledCombs[i] != newCombStates[i]) {
-                for (int ch = 0; ch < numChannels; ++ch) {
-                    comb[ch][i].startFade(newCombStates[i], fadeSamples);
-                }
-                enabledCombs[i] = newCombStates[i];
+            if ((changed & combBit (i)) != 0) {
+                combs.startFade (i, isCombOn (i), fadeSamples, fadeCurve);
+                combs.setWarming (i, false);
             }
         }
-        
+
         for (int i = 0; i < numAllPasses; ++i) {
-            if (enabledAllPasses[i] != newAllPassStates[i]) {
+            if ((changed & allPassBit (i)) != 0) {
                 for (int ch = 0; ch < numChannels; ++ch) {
-                    allPass[ch][i].startFade(newAllPassStates[i], fadeSamples);
+                    allPass[ch][i].startFade (isAllPassOn (i), fadeSamples, fadeCurve);
+                    allPass[ch][i].setWarming (false);
                 }
-                enabledAllPasses[i] = newAllPassStates[i];
             }
         }
+
+        combs.updateActiveLanes();
+        updateAllPassMasks();
     }
 };